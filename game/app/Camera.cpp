@@ -1,24 +1,32 @@
 #include "Camera.h"
 
 void Camera::position(double x, double y) {
-    _camX = x;
-    _camY = y;
+    _focus.x = x;
+    _focus.y = y;
 }
 
 void Camera::target(double x, double y) {
-    _camTargetX = x;
-    _camTargetY = y;
+    _focus.targetX = x;
+    _focus.targetY = y;
 }
 
 void Camera::pan() {
-    _camX += (_camTargetX - _camX) / 8.0;
-    _camY += (_camTargetY - _camY) / 8.0;
+    _focus.x += (_focus.targetX - _focus.x) / 8.0;
+    _focus.y += (_focus.targetY - _focus.y) / 8.0;
 }
 
 int32_t Camera::x() {
-    return static_cast<int32_t>(_camX);
+    return static_cast<int32_t>(_focus.x);
 }
 
 int32_t Camera::y() {
-    return static_cast<int32_t>(_camY);
-}
\ No newline at end of file
+    return static_cast<int32_t>(_focus.y);
+}
+
+const Camera::Focus &Camera::snapshot() const {
+    return _focus;
+}
+
+void Camera::restore(const Focus &focus) {
+    _focus = focus;
+}
@@ -13,10 +13,18 @@ public:
     int32_t x();
     int32_t y();
 
-private:
-    double _camX{0};
-    double _camY{0};
+    struct Focus {
+        double x;
+        double y;
+
+        double targetX;
+        double targetY;
+    };
+
+    const Focus &snapshot() const;
 
-    double _camTargetX{0};
-    double _camTargetY{0};
+    void restore(const Focus &focus);
+
+private:
+    Focus _focus{0, 0, 0, 0};
 };
\ No newline at end of file
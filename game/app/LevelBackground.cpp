@@ -13,4 +13,9 @@ void LevelBackground::scroll(int32_t x, int32_t y) {
 void LevelBackground::draw() {
     _bg.draw();
     _mg.draw();
-}
\ No newline at end of file
+}
+
+void LevelBackground::reload(SL::Engine &engine, SL::Tilemap &map) {
+    _bg = engine.createParallax(map.bgImage().filename(), 6.0f);
+    _mg = engine.createParallax(map.mgImage().filename(), 1.0f);
+}
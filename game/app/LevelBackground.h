@@ -10,6 +10,9 @@ public:
 
     void draw();
 
+    // Picks up the background images of a reloaded map
+    void reload(SL::Engine &engine, SL::Tilemap &map);
+
 private:
     SL::Parallax _bg;
     SL::Parallax _mg;
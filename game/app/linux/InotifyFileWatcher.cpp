@@ -0,0 +1,66 @@
+#include "InotifyFileWatcher.h"
+
+#include <stdexcept>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+InotifyFileWatcher::InotifyFileWatcher() : _fd{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)} {
+    if (_fd < 0) {
+        throw std::runtime_error("Failed to initialise inotify");
+    }
+}
+
+InotifyFileWatcher::~InotifyFileWatcher() {
+    close(_fd);
+}
+
+void InotifyFileWatcher::watch(const std::string &filename, std::function<void()> changeHandler) {
+    // Editors commonly save by writing a temporary file and renaming it over the original,
+    // so the containing directory is watched rather than the file itself.
+    std::string::size_type separator = filename.find_last_of('/');
+    std::string directory = separator == std::string::npos ? "." : filename.substr(0, separator);
+    std::string name = separator == std::string::npos ? filename : filename.substr(separator + 1);
+
+    if (_directories.find(directory) == _directories.end()) {
+        int wd = inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0) {
+            throw std::runtime_error("Failed to watch " + directory);
+        }
+        _directories[directory] = wd;
+    }
+
+    _watchedFiles[_directories[directory]].push_back({name, std::move(changeHandler)});
+}
+
+void InotifyFileWatcher::update() {
+    alignas(inotify_event) char buffer[4096];
+    std::vector<std::function<void()> *> changed;
+
+    ssize_t length;
+    while ((length = read(_fd, buffer, sizeof(buffer))) > 0) {
+        for (char *ptr = buffer; ptr < buffer + length; ptr += sizeof(inotify_event) + reinterpret_cast<inotify_event *>(ptr)->len) {
+            const inotify_event *event = reinterpret_cast<inotify_event *>(ptr);
+            if (event->len == 0) {
+                continue;
+            }
+
+            for (auto &watchedFile : _watchedFiles[event->wd]) {
+                if (watchedFile.name == event->name) {
+                    changed.push_back(&watchedFile.changeHandler);
+                }
+            }
+        }
+    }
+
+    // A single save can raise several events, only reload each file once per poll
+    for (size_t i = 0; i < changed.size(); i++) {
+        bool alreadyReloaded = false;
+        for (size_t j = 0; j < i; j++) {
+            alreadyReloaded |= changed[j] == changed[i];
+        }
+        if (!alreadyReloaded) {
+            (*changed[i])();
+        }
+    }
+}
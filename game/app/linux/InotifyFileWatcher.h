@@ -0,0 +1,28 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <engine.h>
+
+class InotifyFileWatcher : public SL::FileWatcher {
+public:
+    InotifyFileWatcher();
+
+    ~InotifyFileWatcher();
+
+    void update() override;
+
+    void watch(const std::string &filename, std::function<void()> changeHandler) override;
+
+private:
+    struct WatchedFile {
+        std::string name;
+        std::function<void()> changeHandler;
+    };
+
+    int _fd{-1};
+    std::map<std::string, int> _directories;
+    std::map<int, std::vector<WatchedFile>> _watchedFiles;
+};
@@ -4,6 +4,9 @@
 #include <SFML/System.hpp>
 #include <SFML/Graphics.hpp>
 #include <utility>
+#include <cstdlib>
+#include <fstream>
+#include <type_traits>
 
 #include "sfml/SFMLGfx.h"
 #include "sfml/SFMLInput.h"
@@ -12,6 +15,10 @@
 
 #include "fileio.h"
 
+#ifdef __linux__
+#include "linux/InotifyFileWatcher.h"
+#endif
+
 #include "Camera.h"
 #include "LevelBackground.h"
 
@@ -34,7 +41,9 @@ public:
 
     void hitFloor();
 
-    void update(double &x, double &y);
+    void leaveFloor();
+
+    void update();
 
     double xSpeed();
 
@@ -46,91 +55,109 @@ public:
 
     bool isDucking();
 
-private:
-    double _xSpeed{0};
-    double _ySpeed{0};
+    // Everything the physics needs to carry on from a point in time, kept plain so it copies like a value
+    struct Motion {
+        double xSpeed;
+        double ySpeed;
+        double xSpeedAccel;
+        bool onFloor;
+        bool ducking;
+    };
 
-    bool _onFloor{true};
-    double _xSpeedAccel{0.0};
-    bool _ducking{false};
+    const Motion &snapshot() const;
+
+    void restore(const Motion &motion);
+
+private:
+    Motion _motion{0.0, 0.0, 0.0, true, false};
 };
 
 void PlayerPhysics::right() {
-    _xSpeed = 1;
-    _xSpeedAccel = 1.1;
+    _motion.xSpeed = 1;
+    _motion.xSpeedAccel = 1.1;
 }
 
 void PlayerPhysics::left() {
-    _xSpeed = -1;
-    _xSpeedAccel = 1.1;
+    _motion.xSpeed = -1;
+    _motion.xSpeedAccel = 1.1;
 }
 
 void PlayerPhysics::jump() {
-    if (_onFloor) {
-        _ySpeed = -5.0;
-        _onFloor = false;
+    if (_motion.onFloor) {
+        _motion.ySpeed = -5.0;
+        _motion.onFloor = false;
     }
 }
 
 void PlayerPhysics::hitCeiling() {
-    _ySpeed *= -0.8;
+    _motion.ySpeed *= -0.8;
 }
 
 void PlayerPhysics::hitRightWall() {
-    _xSpeed = 0;
+    _motion.xSpeed = 0;
 }
 
 void PlayerPhysics::hitLeftWall() {
-    _xSpeed = 0;
+    _motion.xSpeed = 0;
 }
 
 void PlayerPhysics::hitFloor() {
-    _onFloor = true;
-    _ySpeed = 0.0;
+    _motion.onFloor = true;
+    _motion.ySpeed = 0.0;
 }
 
-void PlayerPhysics::update(double &x, double &y) {
-    x += _xSpeed;
-    y += _ySpeed;
+void PlayerPhysics::leaveFloor() {
+    _motion.onFloor = false;
+}
 
-    _ySpeed += 0.1;
-    _xSpeed *= _xSpeedAccel;
+void PlayerPhysics::update() {
+    _motion.ySpeed += 0.1;
+    _motion.xSpeed *= _motion.xSpeedAccel;
 
-    _xSpeed = std::max(std::min(_xSpeed, 3.0), -3.0);
+    _motion.xSpeed = std::max(std::min(_motion.xSpeed, 3.0), -3.0);
 
-    if (std::abs(_xSpeed) <= 0.1) {
-        _xSpeed = 0;
+    if (std::abs(_motion.xSpeed) <= 0.1) {
+        _motion.xSpeed = 0;
     }
 }
 
 double PlayerPhysics::xSpeed() {
-    return _xSpeed;
+    return _motion.xSpeed;
 }
 
 double PlayerPhysics::ySpeed() {
-    return _ySpeed;
+    return _motion.ySpeed;
 }
 
 bool PlayerPhysics::onFloor() {
-    return _onFloor;
+    return _motion.onFloor;
 }
 
 void PlayerPhysics::idle() {
-    _xSpeedAccel = 0.8;
-    _ducking = false;
+    _motion.xSpeedAccel = 0.8;
+    _motion.ducking = false;
 }
 
 void PlayerPhysics::duck() {
-    _ducking = true;
+    _motion.ducking = true;
 }
 
 bool PlayerPhysics::isDucking() {
-    return _ducking;
+    return _motion.ducking;
+}
+
+const PlayerPhysics::Motion &PlayerPhysics::snapshot() const {
+    return _motion;
+}
+
+void PlayerPhysics::restore(const Motion &motion) {
+    _motion = motion;
 }
 
 class Player {
 public:
-    enum class State {
+    // Matches the order of ANIMATIONS, so a state is also the sprite id of its animation
+    enum class State : SL::SpriteId {
         Idle,
         Walk,
         Jump,
@@ -138,7 +165,9 @@ public:
         Duck
     };
 
-    explicit Player(std::map<std::string, SL::Sprite> &&spriteSet);
+    static const std::vector<std::string> ANIMATIONS;
+
+    explicit Player(SL::SpriteRegistry &&sprites);
 
     void draw(long delta, int x, int y);
 
@@ -156,85 +185,191 @@ public:
 
     void duck();
 
+    void reload(SL::SpriteRegistry &&sprites);
+
+    // The playback points at a clip owned by the sprites, which reload in place, so a pose stays valid
+    struct Pose {
+        SL::AnimationPlayback animation;
+        State state;
+        bool right;
+    };
+
+    const Pose &snapshot() const;
+
+    void restore(const Pose &pose);
+
 private:
-    SL::Sprite _idle;
-    SL::Sprite _walk;
-    SL::Sprite _jump;
-    SL::Sprite _fall;
-    SL::Sprite _duck;
+    SL::AnimationClip *clip();
 
-    bool _right{true};
+    SL::SpriteRegistry _sprites;
 
-    State _state{State::Idle};
+    Pose _pose{SL::AnimationPlayback{}, State::Idle, true};
 };
 
-Player::Player(std::map<std::string, SL::Sprite> &&spriteSet) :
-        _idle{spriteSet.at("idle")},
-        _walk{spriteSet.at("walk")},
-        _jump{spriteSet.at("jump")},
-        _fall{spriteSet.at("fall")},
-        _duck{spriteSet.at("duck")} {
+const std::vector<std::string> Player::ANIMATIONS{"idle", "walk", "jump", "fall", "duck"};
 
+Player::Player(SL::SpriteRegistry &&sprites) : _sprites{std::move(sprites)} {
+    _pose.animation.play(clip());
+}
+
+SL::AnimationClip *Player::clip() {
+    return _sprites[static_cast<SL::SpriteId>(_pose.state)].clip().get();
 }
 
 void Player::draw(long delta, int x, int y) {
-    SL::Sprite *sprite = &_idle;
-
-    if (_state == State::Walk) {
-        sprite = &_walk;
-    } else if (_state == State::Jump) {
-        sprite = &_jump;
-    } else if (_state == State::Fall) {
-        sprite = &_fall;
-    } else if (_state == State::Duck) {
-        sprite = &_duck;
+    _pose.animation.play(clip());
+    _pose.animation.advance(delta);
+    _pose.animation.draw(x, y, !_pose.right);
+}
+
+void Player::reload(SL::SpriteRegistry &&sprites) {
+    for (SL::SpriteId id = 0; id < ANIMATIONS.size(); id++) {
+        _sprites[id].reload(sprites[id]);
     }
 
-    sprite->update(delta);
-    sprite->draw(x, y, !_right);
+    // The playing clip may have lost the current frame
+    _pose.animation = SL::AnimationPlayback{clip(), 0, 0, false};
+}
+
+const Player::Pose &Player::snapshot() const {
+    return _pose;
+}
+
+void Player::restore(const Pose &pose) {
+    _pose = pose;
 }
 
 void Player::lookLeft() {
-    _right = false;
+    _pose.right = false;
 }
 
 void Player::lookRight() {
-    _right = true;
+    _pose.right = true;
 }
 
 void Player::walk() {
-    _state = State::Walk;
+    _pose.state = State::Walk;
 }
 
 void Player::jump() {
-    _state = State::Jump;
+    _pose.state = State::Jump;
 }
 
 void Player::idle() {
-    _state = State::Idle;
+    _pose.state = State::Idle;
 }
 
 void Player::fall() {
-    _state = State::Fall;
+    _pose.state = State::Fall;
 }
 
 void Player::duck() {
-    _state = State::Duck;
+    _pose.state = State::Duck;
 }
 
+static const char *const MAP_FILE = "resources/maps/first.json";
+static const char *const TILESET_FILE = "resources/environment/layers/forest-tileset.png";
+static const char *const PLAYER_SPRITES_FILE = "resources/fox.json";
+static const uint32_t WINDOW_WIDTH = 800;
+static const uint32_t WINDOW_HEIGHT = 600;
+
+// SFMLGfx draws everything at twice its size, so the view covers half the window in game pixels
+static const uint32_t VIEW_WIDTH = WINDOW_WIDTH / 2;
+static const uint32_t VIEW_HEIGHT = WINDOW_HEIGHT / 2;
+
+struct Position {
+    double x;
+    double y;
+};
+
+struct Pickup {
+    int32_t width;
+    int32_t height;
+};
+
+struct Effect {
+    double x;
+    double y;
+    long age;
+};
+
+static const long EFFECT_FRAME_TIME = 83L;
+
 class MainMenuScene : public SL::Scene {
 public:
     explicit MainMenuScene(SL::Engine &engine) :
             _engine{engine},
-            _map{_engine.createMap(readFile("resources/maps/first.json"), "resources/environment/layers/forest-tileset.png")},
+            _map{_engine.createMap(readFile(MAP_FILE), TILESET_FILE)},
             _bg{engine, _map},
-            _player{SL::JSONSpriteFactory{engine}.parse(readFile("resources/fox.json"))} {
+            _player{SL::JSONSpriteFactory{engine}.parse(readFile(PLAYER_SPRITES_FILE), Player::ANIMATIONS)},
+            _carrot{engine.createSprite("resources/spritesheets/misc/carrot.png", 17, 19)},
+            _star{engine.createSprite("resources/spritesheets/misc/star.png", 13, 13)},
+            _sparkles{engine.createParticles("resources/spritesheets/misc/star.png", 13, 13, 256)},
+            _dust{engine.createParticles("resources/spritesheets/misc/enemy-death.png", 31, 29, 64)} {
+
+        // A save with mistakes in it is reported and the game carries on with what it already has
+        _engine.watchFile(MAP_FILE, [&] {
+            try {
+                _map.reload(_engine.createMap(readFile(MAP_FILE), TILESET_FILE));
+                focusMap();
+                _map.waitForChunks();
+            } catch (const std::exception &e) {
+                std::cerr << "Couldn't reload " << MAP_FILE << ": " << e.what() << "\n";
+                return;
+            }
+            _bg.reload(_engine, _map);
+            despawnObjects();
+            spawnObjects();
+        });
+
+        _engine.watchFile(PLAYER_SPRITES_FILE, [&] {
+            try {
+                _player.reload(SL::JSONSpriteFactory{_engine}.parse(readFile(PLAYER_SPRITES_FILE), Player::ANIMATIONS));
+            } catch (const std::exception &e) {
+                std::cerr << "Couldn't reload " << PLAYER_SPRITES_FILE << ": " << e.what() << "\n";
+            }
+        });
 
         _camera.position(_map.cameraSpawnX(), _map.cameraSpawnY());
         _camera.target(_map.playerSpawnX(), _map.playerSpawnY() - 100);
 
+        // Streamed maps need the chunks around the camera before the first frame
+        focusMap();
+        _map.waitForChunks();
+
         _playerX = _map.playerSpawnX();
         _playerY = _map.playerSpawnY();
+
+        _spawner.define<Position, Pickup>("carrot", [&](SL::Registry &objects, SL::Entity entity, const SL::MapObject &object) {
+            objects.add(entity, Position{static_cast<double>(object.x), static_cast<double>(object.y)});
+            objects.add(entity, Pickup{object.width, object.height});
+            _activity.insert(entity.index, object.x, object.y, object.width, object.height);
+        });
+        spawnObjects();
+
+        _checkpoint = snapshot();
+    }
+
+    // The player's simulation state in one plain block, cheap enough to take every frame. Pickups, effects
+    // and particles carry on across a restore
+    struct Snapshot {
+        PlayerPhysics::Motion motion;
+        Player::Pose pose;
+        Camera::Focus camera;
+        double playerX;
+        double playerY;
+    };
+
+    Snapshot snapshot() const {
+        return Snapshot{_playerPhysics.snapshot(), _player.snapshot(), _camera.snapshot(), _playerX, _playerY};
+    }
+
+    void restore(const Snapshot &snapshot) {
+        _playerPhysics.restore(snapshot.motion);
+        _player.restore(snapshot.pose);
+        _camera.restore(snapshot.camera);
+        _playerX = snapshot.playerX;
+        _playerY = snapshot.playerY;
     }
 
     void keyEvent(SL::KeyType key, SL::ActionType action) override {
@@ -274,13 +409,16 @@ public:
     }
 
     void update(long delta) override {
+        focusMap();
+
         _bg.scroll(-_camera.x(), -_camera.y());
         _bg.draw();
 
-        _map.layer(0).draw(static_cast<int32_t>(-_camera.x()), static_cast<int32_t>(-_camera.y()));
-        _map.layer(1).draw(static_cast<int32_t>(-_camera.x()), static_cast<int32_t>(-_camera.y()));
+        _map.update(delta);
+        _map.layer(0).draw(static_cast<int32_t>(-_camera.x()), static_cast<int32_t>(-_camera.y()), VIEW_WIDTH, VIEW_HEIGHT);
+        _map.layer(1).draw(static_cast<int32_t>(-_camera.x()), static_cast<int32_t>(-_camera.y()), VIEW_WIDTH, VIEW_HEIGHT);
 
-        _playerPhysics.update(_playerX, _playerY);
+        _playerPhysics.update();
 
         if (_playerPhysics.ySpeed() > 0.2) {
             _player.fall();
@@ -288,57 +426,160 @@ public:
             _player.jump();
         }
 
-        if (_playerPhysics.ySpeed() > 0) {
-            double playerYOffset = _playerY + 32;
-
-            if (_map.checkCollisionDown(_playerX + 2, playerYOffset, _playerPhysics.ySpeed()) || _map.checkCollisionDown(_playerX + 30, playerYOffset, _playerPhysics.ySpeed())) {
+        SL::Tilemap::Sweep sweep = _map.sweep(_playerX + 2, _playerY, 28, 32, _playerPhysics.xSpeed(), _playerPhysics.ySpeed());
+        _playerX = sweep.x - 2;
+        _playerY = sweep.y;
 
-                _playerY = playerYOffset - 32;
-                _playerPhysics.hitFloor();
+        if (sweep.contacts & SL::Tilemap::ContactDown) {
+            if (!_playerPhysics.onFloor()) {
+                kickUpDust();
+            }
+            _playerPhysics.hitFloor();
 
-                if (_playerPhysics.xSpeed() == 0.0) {
-                    if (_playerPhysics.isDucking()) {
-                        _player.duck();
-                    } else {
-                        _player.idle();
-                    }
+            if (_playerPhysics.xSpeed() == 0.0) {
+                if (_playerPhysics.isDucking()) {
+                    _player.duck();
                 } else {
-                    _player.walk();
+                    _player.idle();
                 }
+            } else {
+                _player.walk();
             }
+        } else {
+            // Walking off a ledge leaves the floor as surely as jumping does
+            _playerPhysics.leaveFloor();
         }
 
-        if (_playerPhysics.ySpeed() < 0) {
-            if (_map.checkCollisionUp(_playerX + 2, _playerY, _playerPhysics.ySpeed()) || _map.checkCollisionUp(_playerX + 30, _playerY, _playerPhysics.ySpeed())) {
-                _playerPhysics.hitCeiling();
-            }
+        if (sweep.contacts & SL::Tilemap::ContactUp) {
+            _playerPhysics.hitCeiling();
         }
 
-        if (_playerPhysics.xSpeed() < 0) {
-            if (_map.checkCollisionLeft(_playerX, _playerY+2, _playerPhysics.xSpeed()) || _map.checkCollisionLeft(_playerX, _playerY+30, _playerPhysics.xSpeed())) {
-                _playerPhysics.hitLeftWall();
-            }
-        } else if (_playerPhysics.xSpeed() > 0) {
-            double playerXOffset = _playerX+32;
-            if (_map.checkCollisionRight(playerXOffset, _playerY+2, _playerPhysics.xSpeed()) || _map.checkCollisionLeft(playerXOffset, _playerY+30, _playerPhysics.xSpeed())) {
-                _playerX = playerXOffset-32;
-                _playerPhysics.hitRightWall();
-            }
+        if (sweep.contacts & SL::Tilemap::ContactLeft) {
+            _playerPhysics.hitLeftWall();
+        } else if (sweep.contacts & SL::Tilemap::ContactRight) {
+            _playerPhysics.hitRightWall();
+        }
+
+        // Falling off the bottom of the map retries from the last place the player stood
+        if (_playerY > _map.height() * 16.0) {
+            restore(_checkpoint);
+        } else if (sweep.contacts & SL::Tilemap::ContactDown) {
+            _checkpoint = snapshot();
         }
 
         _camera.target(_playerX - 100, _playerY - 100);
 
+        _frame++;
+        _activity.update(_frame, _camera.x(), _camera.y(), VIEW_WIDTH, VIEW_HEIGHT, _ticks);
+
+        updatePickups(delta);
+        updateEffects(delta);
+
+        _sparkles.update(delta);
+        _sparkles.draw(-_camera.x(), -_camera.y());
+        _dust.update(delta);
+        _dust.draw(-_camera.x(), -_camera.y());
+
         _player.draw(delta, static_cast<int>(_playerX - _camera.x()), static_cast<int>(_playerY - _camera.y()));
 
         _camera.pan();
     }
 
 private:
+    void focusMap() {
+        _map.focus(_camera.x() + VIEW_WIDTH / 2.0, _camera.y() + VIEW_HEIGHT / 2.0);
+    }
+
+    void spawnObjects() {
+        _spawner.spawn(_map.objects());
+        _collected.reserve(_objects.pool<Pickup>().size());
+        _ticks.reserve(_objects.pool<Pickup>().size());
+    }
+
+    // Reloading a map starts its objects over, so pickups already collected come back
+    void despawnObjects() {
+        _collected.clear();
+        _objects.each<Pickup>([&](SL::Entity entity, Pickup &) {
+            _collected.push_back(entity);
+        });
+
+        for (auto entity : _collected) {
+            _activity.remove(entity.index);
+            _objects.destroy(entity);
+        }
+    }
+
+    void updatePickups(long delta) {
+        _carrot.update(delta);
+
+        // Pickups only matter on screen, so ones the scheduler has at a reduced rate are left alone
+        _collected.clear();
+        SL::ComponentPool<Pickup> &pickups = _objects.pool<Pickup>();
+        SL::ComponentPool<Position> &positions = _objects.pool<Position>();
+        for (auto &tick : _ticks) {
+            if (tick.activity != SL::ActivityScheduler::Activity::Active || !pickups.contains(tick.id)) {
+                continue;
+            }
+
+            Pickup &pickup = pickups.get(tick.id);
+            Position &position = positions.get(tick.id);
+            if (position.x < _playerX + 32 && position.x + pickup.width > _playerX && position.y < _playerY + 32 && position.y + pickup.height > _playerY) {
+                _collected.push_back(_objects.entity(tick.id));
+                _effects.spawn(Effect{position.x + (pickup.width - 13) / 2.0, position.y + (pickup.height - 13) / 2.0, 0L});
+                sparkle(static_cast<float>(position.x + pickup.width / 2.0), static_cast<float>(position.y + pickup.height / 2.0));
+            } else {
+                _carrot.draw(static_cast<int32_t>(position.x - _camera.x()), static_cast<int32_t>(position.y - _camera.y()));
+            }
+        }
+
+        for (auto entity : _collected) {
+            _activity.remove(entity.index);
+            _objects.destroy(entity);
+        }
+    }
+
+    void sparkle(float x, float y) {
+        for (int32_t i = 0; i < 12; i++) {
+            float angle = i * 0.5235988f;
+            _sparkles.emit(x - 6.5f, y - 6.5f, std::cos(angle) * 60.0f, std::sin(angle) * 60.0f, 500.0f);
+        }
+    }
+
+    void kickUpDust() {
+        float feetX = static_cast<float>(_playerX) + 1.0f;
+        float feetY = static_cast<float>(_playerY) + 32.0f - 29.0f;
+        _dust.emit(feetX - 12.0f, feetY, -30.0f, -10.0f, 400.0f);
+        _dust.emit(feetX + 12.0f, feetY, 30.0f, -10.0f, 400.0f);
+    }
+
+    void updateEffects(long delta) {
+        _effects.each([&](SL::ObjectPool<Effect>::Handle handle, Effect &effect) {
+            effect.age += delta;
+            uint32_t frame = static_cast<uint32_t>(effect.age / EFFECT_FRAME_TIME);
+            if (frame >= _star.frameCount()) {
+                _effects.despawn(handle);
+            } else {
+                _star.drawFrame(frame, static_cast<int32_t>(effect.x - _camera.x()), static_cast<int32_t>(effect.y - _camera.y()));
+            }
+        });
+    }
 
     SL::Engine &_engine;
     SL::Tilemap _map;
     LevelBackground _bg;
     Player _player;
+    SL::Sprite _carrot;
+    SL::Sprite _star;
+    SL::ParticleSystem _sparkles;
+    SL::ParticleSystem _dust;
+
+    SL::Registry _objects{};
+    SL::ObjectSpawner _spawner{_objects};
+    SL::ActivityScheduler _activity{4, 32, 160, 4};
+    std::vector<SL::ActivityScheduler::Tick> _ticks{};
+    uint64_t _frame{0};
+    std::vector<SL::Entity> _collected{};
+    SL::ObjectPool<Effect> _effects{32};
 
     double _playerX;
     double _playerY;
@@ -346,8 +587,12 @@ private:
     PlayerPhysics _playerPhysics{};
 
     Camera _camera{};
+
+    Snapshot _checkpoint{};
 };
 
+static_assert(std::is_trivially_copyable<MainMenuScene::Snapshot>::value, "Scene snapshots are copied as plain memory");
+
 class TitleScene : public SL::Scene {
 public:
     TitleScene(SL::Engine &engine, std::function<void()> closeScreen) : _bg{engine.createParallax("resources/environment/layers/island-background.png", 4.0f)}, _mg{engine.createParallax("resources/environment/layers/island-middleground.png", 1.0f)}, _title{engine.createSprite("resources/title/title.png")}, _closeScreen{
@@ -383,26 +628,126 @@ private:
     double _phase{0.0};
 };
 
+// Startup profiling is requested with --startup-profile[=report.json] or SUNNYLAND_STARTUP_PROFILE,
+// the report is written as JSON when a .json file is given and printed to stdout otherwise.
+bool startupProfileRequested(int argc, char **argv, std::string &reportFile) {
+    const std::string flag = "--startup-profile";
+    for (int i = 1; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (arg == flag) {
+            return true;
+        } else if (arg.compare(0, flag.size() + 1, flag + "=") == 0) {
+            reportFile = arg.substr(flag.size() + 1);
+            return true;
+        }
+    }
+
+    const char *env = std::getenv("SUNNYLAND_STARTUP_PROFILE");
+    if (env != nullptr) {
+        std::string value{env};
+        if (value.size() > 5 && value.compare(value.size() - 5, 5, ".json") == 0) {
+            reportFile = value;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+// Returns the value of a --flag=value argument, or an empty string when it isn't given
+std::string flagValue(int argc, char **argv, const std::string &flag) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (arg.compare(0, flag.size() + 1, flag + "=") == 0) {
+            return arg.substr(flag.size() + 1);
+        }
+    }
+    return "";
+}
+
 int main(int argc, char **argv) {
-    sf::RenderWindow window{{800, 600}, "SunnyLand"};
+    SL::StartupProfiler startupProfiler{};
+    std::string startupReportFile{};
+    bool profileStartup = startupProfileRequested(argc, argv, startupReportFile);
+
+    uint64_t windowStart = startupProfiler.elapsedMicros();
+    sf::RenderWindow window{{WINDOW_WIDTH, WINDOW_HEIGHT}, "SunnyLand"};
     window.setKeyRepeatEnabled(false);
     window.setFramerateLimit(60);
     window.setVerticalSyncEnabled(true);
+    startupProfiler.record("create window", windowStart, startupProfiler.elapsedMicros() - windowStart, 0);
+
     SFMLGfx gfx{window};
     SFMLInput input{window};
     SFMLTime time{};
     SFMLSleeper sleeper{};
 
-    SL::Engine engine{&gfx, &input, &time, &sleeper};
+    // A replay stands in for the keyboard and clock, and runs as fast as the frames can be drawn
+    std::string replayFile = flagValue(argc, argv, "--replay-input");
+    std::unique_ptr<SL::ReplayInput> replay{};
+    SL::Input *engineInput = &input;
+    SL::Time *engineTime = &time;
+    SL::Sleeper *engineSleeper = &sleeper;
+    if (!replayFile.empty()) {
+        replay.reset(new SL::ReplayInput{SL::InputRecording::parse(readFile(replayFile))});
+        engineInput = replay.get();
+        engineTime = replay.get();
+        engineSleeper = replay.get();
+        window.setFramerateLimit(0);
+        window.setVerticalSyncEnabled(false);
+    }
+
+    SL::Engine engine{&gfx, engineInput, engineTime, engineSleeper};
+
+    std::string recordFile = flagValue(argc, argv, "--record-input");
+    SL::InputRecorder recorder{};
+    if (!recordFile.empty()) {
+        engine.recordInput(&recorder);
+    }
+
+    if (profileStartup) {
+        engine.profileStartup(&startupProfiler);
+    }
+
+#ifdef __linux__
+    // inotify can run out of instances, so the watcher is only created when hot reload is asked for
+    std::unique_ptr<InotifyFileWatcher> fileWatcher{};
+    if (std::getenv("SUNNYLAND_HOT_RELOAD") != nullptr) {
+        fileWatcher.reset(new InotifyFileWatcher{});
+        engine.enableHotReload(fileWatcher.get());
+    }
+#endif
 
+    uint64_t scenesStart = startupProfiler.elapsedMicros();
     MainMenuScene mainMenuScene{engine};
     TitleScene titleScene{engine, [&]{
         engine.displayScene(&mainMenuScene);
     }};
+    startupProfiler.record("construct scenes", scenesStart, startupProfiler.elapsedMicros() - scenesStart, 0);
 
     engine.displayScene(&titleScene);
 
-    while (engine.update());
+    // The first frame is drawn during one update and presented at the start of the next
+    uint64_t firstFrameStart = startupProfiler.elapsedMicros();
+    bool running = engine.update() && engine.update();
+    startupProfiler.record("first frame", firstFrameStart, startupProfiler.elapsedMicros() - firstFrameStart, 0);
+
+    if (profileStartup) {
+        engine.profileStartup(nullptr);
+        if (startupReportFile.empty()) {
+            startupProfiler.report(std::cout);
+        } else {
+            std::ofstream reportFile{startupReportFile};
+            startupProfiler.reportJSON(reportFile);
+        }
+    }
+
+    while (running && engine.update());
+
+    if (!recordFile.empty()) {
+        std::ofstream recording{recordFile};
+        recorder.recording().write(recording);
+    }
 
     return 0;
 }
\ No newline at end of file
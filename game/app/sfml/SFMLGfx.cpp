@@ -27,6 +27,30 @@ void SFMLGfx::drawImage(SL::Image &image, int32_t x, int32_t y, int32_t sourceX,
     _window.draw(sprite);
 }
 
+void SFMLGfx::drawQuads(SL::Image &image, const std::vector<SL::Quad> &quads) {
+    // The vertex array keeps its storage between batches
+    _quads.resize(quads.size() * 4);
+    for (size_t i = 0; i < quads.size(); i++) {
+        const SL::Quad &quad = quads[i];
+        float left = quad.x * 2.0f;
+        float top = quad.y * 2.0f;
+        float right = (quad.x + quad.width) * 2.0f;
+        float bottom = (quad.y + quad.height) * 2.0f;
+        float sourceLeft = static_cast<float>(quad.sourceX);
+        float sourceTop = static_cast<float>(quad.sourceY);
+        float sourceRight = static_cast<float>(quad.sourceX + quad.width);
+        float sourceBottom = static_cast<float>(quad.sourceY + quad.height);
+
+        sf::Vertex *vertex = &_quads[i * 4];
+        vertex[0] = sf::Vertex{{left, top}, {sourceLeft, sourceTop}};
+        vertex[1] = sf::Vertex{{right, top}, {sourceRight, sourceTop}};
+        vertex[2] = sf::Vertex{{right, bottom}, {sourceRight, sourceBottom}};
+        vertex[3] = sf::Vertex{{left, bottom}, {sourceLeft, sourceBottom}};
+    }
+
+    _window.draw(_quads, &_loadedImages[image.filename()]);
+}
+
 void SFMLGfx::drawBackgroundLayer(SL::Image &image, int32_t offsetX, int32_t offsetY) {
     auto &texture = _loadedImages[image.filename()];
     texture.setRepeated(true);
@@ -14,6 +14,8 @@ public:
 
     void drawBackgroundLayer(SL::Image &image, int32_t offsetX, int32_t offsetY) override;
 
+    void drawQuads(SL::Image &image, const std::vector<SL::Quad> &quads) override;
+
     SL::Image loadImage(const std::string &filename) override;
 
     void update() override;
@@ -21,4 +23,5 @@ public:
 private:
     sf::RenderWindow &_window;
     std::map<std::string, sf::Texture> _loadedImages;
+    sf::VertexArray _quads{sf::Quads};
 };
\ No newline at end of file
@@ -1,15 +1,18 @@
 #include "SFMLInput.h"
 
-SFMLInput::SFMLInput(sf::RenderWindow &window) : _window{window} {
+const int8_t SFMLInput::Unmapped;
 
+SFMLInput::SFMLInput(sf::RenderWindow &window) : _window{window} {
+    _keys.fill(Unmapped);
+    _keys[sf::Keyboard::Key::Left] = static_cast<int8_t>(SL::KeyType::Left);
+    _keys[sf::Keyboard::Key::Right] = static_cast<int8_t>(SL::KeyType::Right);
+    _keys[sf::Keyboard::Key::Down] = static_cast<int8_t>(SL::KeyType::Down);
+    _keys[sf::Keyboard::Key::Up] = static_cast<int8_t>(SL::KeyType::Up);
+    _keys[sf::Keyboard::Key::Space] = static_cast<int8_t>(SL::KeyType::Jump);
 }
 
 void SFMLInput::update() {
-    static auto interestingKeys = std::vector<std::pair<sf::Keyboard::Key, SL::KeyType>>{{sf::Keyboard::Key::Left,  SL::KeyType::Left},
-                                                                                         {sf::Keyboard::Key::Right, SL::KeyType::Right},
-                                                                                         {sf::Keyboard::Key::Down,  SL::KeyType::Down},
-                                                                                         {sf::Keyboard::Key::Up,    SL::KeyType::Up},
-                                                                                         {sf::Keyboard::Key::Space, SL::KeyType::Jump}};
+    _events.clear();
 
     sf::Event e{};
     while (_window.pollEvent(e)) {
@@ -17,19 +20,29 @@ void SFMLInput::update() {
             _quitHandler();
         }
 
-        for (auto &keymap : interestingKeys) {
-            if (e.type == sf::Event::KeyPressed) {
-                if (e.key.code == keymap.first) {
-                    _keyHandler(keymap.second, SL::ActionType::Press);
-                }
-            }
-
-            if (e.type == sf::Event::KeyReleased) {
-                if (e.key.code == keymap.first) {
-                    _keyHandler(keymap.second, SL::ActionType::Release);
-                }
-            }
+        if (e.type != sf::Event::KeyPressed && e.type != sf::Event::KeyReleased) {
+            continue;
+        }
+
+        // Unknown keys come through as -1
+        if (e.key.code < 0 || e.key.code >= sf::Keyboard::KeyCount || _keys[e.key.code] == Unmapped) {
+            continue;
         }
+
+        SL::ActionType action = e.type == sf::Event::KeyPressed ? SL::ActionType::Press : SL::ActionType::Release;
+        SL::InputEvent event{static_cast<SL::KeyType>(_keys[e.key.code]), action, static_cast<uint64_t>(_clock.getElapsedTime().asMicroseconds())};
+
+        // A full queue grows rather than dropping the event, a lost release would leave the key held down
+        if (!_events.push(event)) {
+            _events.reserve(_events.capacity() * 2);
+            _events.push(event);
+        }
+    }
+
+    for (auto &keyHandler : _keyHandlers) {
+        _events.drain(keyHandler.cursor, [&](const SL::InputEvent &event) {
+            keyHandler.handler(event.key, event.action);
+        });
     }
 }
 
@@ -38,5 +51,9 @@ void SFMLInput::addQuitHandler(std::function<void()> quitHandler) {
 }
 
 void SFMLInput::addKeyHandler(std::function<void(SL::KeyType, SL::ActionType)> keyHandler) {
-    _keyHandler = keyHandler;
+    _keyHandlers.push_back(KeyHandler{std::move(keyHandler), SL::InputQueue::Cursor{0, 0}});
+}
+
+const SL::InputQueue &SFMLInput::events() const {
+    return _events;
 }
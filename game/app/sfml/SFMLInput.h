@@ -1,6 +1,8 @@
 #pragma once
 
+#include <array>
 #include <functional>
+#include <vector>
 
 #include <engine.h>
 #include <SFML/Graphics.hpp>
@@ -11,12 +13,26 @@ public:
 
     void update() override;
 
+    // Every handler added is called, in the order added, for each of the tick's events
     void addKeyHandler(std::function<void(SL::KeyType, SL::ActionType)> keyHandler) override;
 
     void addQuitHandler(std::function<void()> quitHandler) override;
 
+    // This tick's key events, timestamped when they were polled. The queue grows rather than drop any of them.
+    const SL::InputQueue &events() const override;
+
 private:
+    struct KeyHandler {
+        std::function<void(SL::KeyType, SL::ActionType)> handler;
+        SL::InputQueue::Cursor cursor;
+    };
+
+    static const int8_t Unmapped = -1;
+
     sf::RenderWindow &_window;
+    sf::Clock _clock{};
+    std::array<int8_t, sf::Keyboard::KeyCount> _keys;
+    SL::InputQueue _events{64};
     std::function<void()> _quitHandler;
-    std::function<void(SL::KeyType, SL::ActionType)> _keyHandler;
-};
\ No newline at end of file
+    std::vector<KeyHandler> _keyHandlers;
+};
@@ -0,0 +1,51 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include <engine.h>
+
+#include "MockGfx.h"
+
+namespace {
+    template<typename F>
+    double secondsFor(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main() {
+    const uint32_t particles = 50000;
+    const uint32_t frames = 600;
+
+    MockGfx gfx;
+    gfx.simulateAvailableImage("resources/spritesheets/misc/star.png", 78, 13);
+
+    SL::ParticleSystem system{&gfx, gfx.loadImage("resources/spritesheets/misc/star.png"), 13, 13, particles};
+    system.gravity(400.0f);
+
+    std::mt19937 random{1234};
+    std::uniform_real_distribution<float> position{0.0f, 400.0f};
+    std::uniform_real_distribution<float> velocity{-60.0f, 60.0f};
+    std::uniform_real_distribution<float> lifetime{200.0f, 1000.0f};
+
+    // Dead particles are replaced every frame, so the system stays full while particles keep expiring
+    double updateSeconds = 0.0;
+    double drawSeconds = 0.0;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        while (system.emit(position(random), position(random), velocity(random), velocity(random), lifetime(random))) {
+        }
+        updateSeconds += secondsFor([&] {
+            system.update(16);
+        });
+        drawSeconds += secondsFor([&] {
+            system.draw(0, 0);
+        });
+    }
+
+    std::cout << "particles: " << particles << " particles, update " << updateSeconds / frames * 1000.0 << "ms/frame, draw "
+              << drawSeconds / frames * 1000.0 << "ms/frame (" << gfx.quadBatches << " batches)" << std::endl;
+
+    return 0;
+}
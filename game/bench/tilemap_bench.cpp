@@ -0,0 +1,167 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include <engine.h>
+
+#include "MockGfx.h"
+#include "MockInput.h"
+#include "MockSleeper.h"
+#include "MockTime.h"
+
+namespace {
+    std::string readResource(const std::string &filename) {
+        std::ifstream file{std::string{SL_RESOURCES_DIR} + "/" + filename};
+        std::stringstream data;
+        data << file.rdbuf();
+        return data.str();
+    }
+
+    template<typename F>
+    double secondsFor(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void raycast(SL::Tilemap &map) {
+        const uint32_t rays = 2000000;
+        std::mt19937 random{1234};
+        std::uniform_real_distribution<double> positionX{0.0, map.width() * 16.0};
+        std::uniform_real_distribution<double> positionY{0.0, map.height() * 16.0};
+        std::uniform_real_distribution<double> angle{0.0, 6.283185307179586};
+
+        std::vector<double> originX(rays), originY(rays), directionX(rays), directionY(rays);
+        for (uint32_t i = 0; i < rays; i++) {
+            originX[i] = positionX(random);
+            originY[i] = positionY(random);
+            double directionAngle = angle(random);
+            directionX[i] = std::cos(directionAngle);
+            directionY[i] = std::sin(directionAngle);
+        }
+
+        uint32_t hits = 0;
+        double seconds = secondsFor([&] {
+            for (uint32_t i = 0; i < rays; i++) {
+                hits += map.raycast(originX[i], originY[i], directionX[i], directionY[i], 400.0).hit;
+            }
+        });
+
+        std::cout << "raycast: " << rays << " rays of up to 400px in " << seconds << "s, "
+                  << rays / seconds / 1000000.0 << " million rays/s (" << hits << " hits)" << std::endl;
+    }
+
+    // Generated terrain with a ground line, floating platforms and scattered decoration, wide enough that a
+    // row-major map row spans many cache lines
+    std::vector<uint32_t> generateTiles(uint32_t width, uint32_t height) {
+        std::mt19937 random{42};
+        std::uniform_int_distribution<uint32_t> tile{1, 240};
+        std::uniform_int_distribution<uint32_t> chance{0, 99};
+        std::vector<uint32_t> tiles(width * height, 0);
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t ground = height - 8 - static_cast<uint32_t>((std::sin(x * 0.05) + 1.0) * 16.0);
+            for (uint32_t y = 0; y < height; y++) {
+                if (y >= ground || chance(random) < 8) {
+                    tiles[y * width + x] = tile(random);
+                }
+            }
+        }
+        return tiles;
+    }
+
+    const char *layoutName(SL::Tilemap::TileLayout layout) {
+        return layout == SL::Tilemap::TileLayout::Blocked ? "blocked" : "row-major";
+    }
+
+    void layoutWorkloads(MockGfx &gfx, SL::Tilemap::TileLayout layout, const std::vector<uint32_t> &tiles, uint32_t width, uint32_t height) {
+        SL::Tilemap::Layer layer{&gfx, SL::Image{"tileset", 320, 192}, width, height, tiles, layout};
+        std::mt19937 random{1234};
+        std::uniform_int_distribution<uint32_t> tileX{1, width - 2};
+        std::uniform_int_distribution<uint32_t> tileY{1, height - 2};
+        uint64_t checksum = 0;
+
+        // Culling: visit the 25x19 tiles of the game's 400x300 view at random camera positions
+        const uint32_t views = 20000;
+        double cullSeconds = secondsFor([&] {
+            for (uint32_t i = 0; i < views; i++) {
+                uint32_t left = tileX(random);
+                uint32_t top = tileY(random);
+                layer.visit(left, top, left + 24, top + 18, [&](uint32_t, uint32_t, int32_t tile) {
+                    checksum += tile != 0;
+                });
+            }
+        });
+
+        // Collision: probe straight down from random points until ground, then read the 3x3 neighbourhood
+        const uint32_t probes = 1000000;
+        double collisionSeconds = secondsFor([&] {
+            for (uint32_t i = 0; i < probes; i++) {
+                uint32_t x = tileX(random);
+                uint32_t y = tileY(random);
+                while (y < height - 2 && layer.tile(x, y + 1) == 0) {
+                    y++;
+                }
+                for (uint32_t ny = y - 1; ny <= y + 1; ny++) {
+                    for (uint32_t nx = x - 1; nx <= x + 1; nx++) {
+                        checksum += layer.tile(nx, ny);
+                    }
+                }
+            }
+        });
+
+        // Raycast: step tile by tile along random directions reading the layer until a tile is hit
+        const uint32_t rays = 1000000;
+        std::uniform_real_distribution<double> angle{0.0, 6.283185307179586};
+        double raySeconds = secondsFor([&] {
+            for (uint32_t i = 0; i < rays; i++) {
+                double x = tileX(random) + 0.5;
+                double y = tileY(random) + 0.5;
+                double directionAngle = angle(random);
+                double dx = std::cos(directionAngle);
+                double dy = std::sin(directionAngle);
+                for (uint32_t step = 0; step < 64 && x >= 0 && y >= 0 && x < width && y < height; step++) {
+                    if (layer.tile(static_cast<uint32_t>(x), static_cast<uint32_t>(y)) != 0) {
+                        checksum++;
+                        break;
+                    }
+                    x += dx;
+                    y += dy;
+                }
+            }
+        });
+
+        std::cout << layoutName(layout) << " " << width << "x" << height << ": cull " << views << " views in " << cullSeconds
+                  << "s, collide " << probes << " probes in " << collisionSeconds << "s, raycast " << rays << " rays in "
+                  << raySeconds << "s (checksum " << checksum << ")" << std::endl;
+    }
+
+    void tileLayouts(MockGfx &gfx) {
+        const uint32_t width = 8192;
+        const uint32_t height = 512;
+        std::vector<uint32_t> tiles = generateTiles(width, height);
+        layoutWorkloads(gfx, SL::Tilemap::TileLayout::RowMajor, tiles, width, height);
+        layoutWorkloads(gfx, SL::Tilemap::TileLayout::Blocked, tiles, width, height);
+    }
+}
+
+int main() {
+    MockGfx gfx;
+    MockInput input;
+    MockTime time;
+    MockSleeper sleeper;
+
+    gfx.simulateAvailableImage("resources/environment/layers/forest-tileset.png", 320, 192);
+    gfx.simulateAvailableImage("resources/environment/layers/island-background.png", 10, 10);
+    gfx.simulateAvailableImage("resources/environment/layers/island-middleground.png", 10, 10);
+
+    SL::Engine engine{&gfx, &input, &time, &sleeper};
+    SL::Tilemap map = engine.createMap(readResource("maps/first.json"), "resources/environment/layers/forest-tileset.png");
+
+    raycast(map);
+    tileLayouts(gfx);
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <algorithm>
+
+#include "engine.h"
+
+SL::ActivityScheduler::ActivityScheduler(uint32_t tilesPerCell, double activeMargin, double reducedMargin, uint32_t reducedRate)
+        : _grid{tilesPerCell}, _activeMargin{activeMargin}, _reducedMargin{std::max(reducedMargin, activeMargin)}, _reducedRate{std::max(reducedRate, 1u)} {
+}
+
+void SL::ActivityScheduler::insert(uint32_t id, double x, double y, double width, double height) {
+    if (id >= _states.size()) {
+        _states.resize(id + 1, State{0, 0, 0, 0, 0, 0, Activity::Asleep, false, false});
+    }
+
+    State &state = _states[id];
+    if (state.present) {
+        move(id, x, y, width, height);
+        return;
+    }
+
+    // A new entity counts as having ticked on the current frame, so it doesn't wake with a backlog to catch up on
+    state = State{x, y, width, height, _frame, 0, Activity::Asleep, false, true};
+    _grid.insert(id, x, y, width, height);
+}
+
+void SL::ActivityScheduler::move(uint32_t id, double x, double y, double width, double height) {
+    State &state = _states[id];
+    state.x = x;
+    state.y = y;
+    state.width = width;
+    state.height = height;
+    _grid.move(id, x, y, width, height);
+}
+
+void SL::ActivityScheduler::remove(uint32_t id) {
+    if (id >= _states.size() || !_states[id].present) {
+        return;
+    }
+
+    _states[id].present = false;
+    _grid.remove(id);
+}
+
+void SL::ActivityScheduler::update(uint64_t frame, double viewX, double viewY, double viewWidth, double viewHeight, std::vector<Tick> &ticks) {
+    _frame = frame;
+    ticks.clear();
+    _nearby.clear();
+    _grid.query(viewX - _reducedMargin, viewY - _reducedMargin, viewWidth + 2 * _reducedMargin, viewHeight + 2 * _reducedMargin, _nearby);
+
+    // Cells list entities in the order they arrived, sorting keeps the update order independent of movement history
+    std::sort(_nearby.begin(), _nearby.end());
+
+    double activeLeft = viewX - _activeMargin;
+    double activeTop = viewY - _activeMargin;
+    double activeRight = viewX + viewWidth + _activeMargin;
+    double activeBottom = viewY + viewHeight + _activeMargin;
+
+    for (uint32_t id : _nearby) {
+        State &state = _states[id];
+        bool woke = !state.seen || state.lastSeen + 1 != frame;
+        state.seen = true;
+        state.lastSeen = frame;
+
+        bool active = state.x < activeRight && activeLeft < state.x + state.width && state.y < activeBottom && activeTop < state.y + state.height;
+        state.activity = active ? Activity::Active : Activity::Reduced;
+
+        // Waking always ticks so the entity catches up on the frame it comes back into range, not some frames later
+        if (active || woke || (frame + id) % _reducedRate == 0) {
+            ticks.push_back(Tick{id, state.activity, static_cast<uint32_t>(frame - state.lastTick), woke});
+            state.lastTick = frame;
+        }
+    }
+}
+
+SL::ActivityScheduler::Activity SL::ActivityScheduler::activity(uint32_t id) const {
+    if (id >= _states.size() || !_states[id].present || !_states[id].seen || _states[id].lastSeen != _frame) {
+        return Activity::Asleep;
+    }
+    return _states[id].activity;
+}
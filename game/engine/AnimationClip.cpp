@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <numeric>
+
+#include "engine.h"
+
+const uint32_t SL::AnimationClip::DefaultFrameDuration;
+
+namespace {
+    std::vector<SL::Rect> gridFrames(SL::Image &image, uint32_t cellWidth, uint32_t cellHeight, uint32_t count) {
+        uint32_t columns = image.width() / cellWidth;
+        uint32_t cells = std::min(columns * (image.height() / cellHeight), count);
+
+        std::vector<SL::Rect> frames;
+        frames.reserve(cells);
+        for (uint32_t cell = 0; cell < cells; cell++) {
+            frames.push_back(SL::Rect{static_cast<int32_t>(cell % columns * cellWidth), static_cast<int32_t>(cell / columns * cellHeight),
+                                      static_cast<int32_t>(cellWidth), static_cast<int32_t>(cellHeight)});
+        }
+        return frames;
+    }
+}
+
+SL::AnimationClip::AnimationClip(SL::Gfx *gfx, SL::Image image, uint32_t cellWidth, uint32_t cellHeight, std::vector<uint32_t> frameDurations, Loop loop,
+                                 uint32_t count) : AnimationClip(gfx, image, gridFrames(image, cellWidth, cellHeight, count), std::move(frameDurations), loop) {
+}
+
+SL::AnimationClip::AnimationClip(SL::Gfx *gfx, SL::Image image, std::vector<SL::Rect> frames, std::vector<uint32_t> frameDurations, Loop loop)
+        : _gfx{gfx}, _image{std::move(image)}, _frames{std::move(frames)}, _frameDurations{std::move(frameDurations)}, _duration{0}, _loop{loop} {
+    _frameDurations.resize(_frames.size(), _frameDurations.empty() ? DefaultFrameDuration : _frameDurations.back());
+    _duration = std::accumulate(_frameDurations.begin(), _frameDurations.end(), 0u);
+}
+
+uint32_t SL::AnimationClip::frameCount() const {
+    return static_cast<uint32_t>(_frames.size());
+}
+
+const SL::Rect &SL::AnimationClip::frame(uint32_t frame) const {
+    return _frames[frame];
+}
+
+uint32_t SL::AnimationClip::frameDuration(uint32_t frame) const {
+    return _frameDurations[frame];
+}
+
+uint32_t SL::AnimationClip::duration() const {
+    return _duration;
+}
+
+SL::AnimationClip::Loop SL::AnimationClip::loop() const {
+    return _loop;
+}
+
+void SL::AnimationClip::draw(uint32_t frame, int32_t x, int32_t y, bool horizontallyFlipped) {
+    if (_frames.empty()) {
+        return;
+    }
+    const Rect &source = _frames[frame < _frames.size() ? frame : frame % _frames.size()];
+    _gfx->drawImage(_image, x, y, source.x, source.y, source.width, source.height, horizontallyFlipped);
+}
+
+bool SL::AnimationClip::operator==(const SL::AnimationClip &other) const {
+    return _image.filename() == other._image.filename() && _frames == other._frames && _frameDurations == other._frameDurations && _loop == other._loop;
+}
+
+bool SL::AnimationClip::operator!=(const SL::AnimationClip &other) const {
+    return !(*this == other);
+}
+
+void SL::AnimationPlayback::play(SL::AnimationClip *newClip) {
+    if (clip != newClip) {
+        *this = AnimationPlayback{newClip, 0, 0, false};
+    }
+}
+
+void SL::AnimationPlayback::advance(long timeDelta) {
+    if (clip == nullptr || finished || clip->frameCount() == 0) {
+        return;
+    }
+
+    // A reload may have left the clip with fewer frames than this playback had reached
+    if (frame >= clip->frameCount()) {
+        frame = 0;
+        elapsed = 0;
+    }
+
+    // After a long pause whole passes through the clip are skipped, rather than stepping through every frame of them
+    uint64_t pending = static_cast<uint64_t>(elapsed) + static_cast<uint64_t>(std::max(timeDelta, 0L));
+    if (clip->duration() > 0 && pending >= clip->duration()) {
+        if (clip->loop() == AnimationClip::Loop::Repeat) {
+            pending %= clip->duration();
+        } else {
+            frame = static_cast<uint16_t>(clip->frameCount() - 1);
+            finished = true;
+            elapsed = 0;
+            return;
+        }
+    }
+    elapsed = static_cast<uint32_t>(pending);
+
+    while (elapsed >= clip->frameDuration(frame)) {
+        if (clip->frameDuration(frame) == 0) {
+            break;
+        }
+        elapsed -= clip->frameDuration(frame);
+
+        if (frame + 1u < clip->frameCount()) {
+            frame++;
+        } else if (clip->loop() == AnimationClip::Loop::Repeat) {
+            frame = 0;
+        } else {
+            finished = true;
+            elapsed = 0;
+            break;
+        }
+    }
+}
+
+void SL::AnimationPlayback::draw(int32_t x, int32_t y, bool horizontallyFlipped) const {
+    if (clip != nullptr) {
+        clip->draw(frame, x, y, horizontallyFlipped);
+    }
+}
+
+void SL::AnimationPlayback::advanceAll(std::vector<SL::AnimationPlayback> &playbacks, long timeDelta) {
+    for (auto &playback : playbacks) {
+        playback.advance(timeDelta);
+    }
+}
@@ -0,0 +1,25 @@
+#include "engine.h"
+
+void SL::BodyBatch::add(double bodyX, double bodyY, double bodyWidth, double bodyHeight, double bodyVelocityX, double bodyVelocityY) {
+    x.push_back(bodyX);
+    y.push_back(bodyY);
+    width.push_back(bodyWidth);
+    height.push_back(bodyHeight);
+    velocityX.push_back(bodyVelocityX);
+    velocityY.push_back(bodyVelocityY);
+    contacts.push_back(0);
+}
+
+void SL::BodyBatch::clear() {
+    x.clear();
+    y.clear();
+    width.clear();
+    height.clear();
+    velocityX.clear();
+    velocityY.clear();
+    contacts.clear();
+}
+
+size_t SL::BodyBatch::size() {
+    return x.size();
+}
@@ -0,0 +1,168 @@
+#include "engine.h"
+
+SL::ChunkStreamer::ChunkStreamer(uint32_t width, uint32_t height, uint32_t chunkSize, uint32_t radius, ChunkLoader loader)
+        : _w{width}, _h{height}, _chunkSize{chunkSize}, _radius{radius}, _loader{std::move(loader)} {
+    if (width == 0 || height == 0 || chunkSize == 0) {
+        throw std::domain_error("Streamed map and chunks must have a size");
+    }
+
+    _worker = std::thread{&ChunkStreamer::load, this};
+}
+
+SL::ChunkStreamer::~ChunkStreamer() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _alive = false;
+    }
+    _requestsAvailable.notify_one();
+    _worker.join();
+}
+
+void SL::ChunkStreamer::focus(uint32_t tileX, uint32_t tileY) {
+    _focusChunkX = std::min(tileX, _w - 1) / _chunkSize;
+    _focusChunkY = std::min(tileY, _h - 1) / _chunkSize;
+
+    integrateLoadedChunks();
+
+    // Chunks are kept for one ring beyond the load radius so that hovering over a chunk border
+    // doesn't thrash between loading and evicting the same chunks.
+    for (auto it = _resident.begin(); it != _resident.end();) {
+        if (!inRange(it->first, _radius + 1)) {
+            it = _resident.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    uint32_t chunksWide = (_w + _chunkSize - 1) / _chunkSize;
+    uint32_t chunksHigh = (_h + _chunkSize - 1) / _chunkSize;
+    uint32_t left = _focusChunkX > _radius ? _focusChunkX - _radius : 0;
+    uint32_t top = _focusChunkY > _radius ? _focusChunkY - _radius : 0;
+    uint32_t right = std::min(_focusChunkX + _radius, chunksWide - 1);
+    uint32_t bottom = std::min(_focusChunkY + _radius, chunksHigh - 1);
+
+    std::vector<ChunkKey> requests;
+    for (uint32_t chunkY = top; chunkY <= bottom; chunkY++) {
+        for (uint32_t chunkX = left; chunkX <= right; chunkX++) {
+            ChunkKey chunk = key(chunkX, chunkY);
+            if (_resident.find(chunk) == _resident.end() && _requested.find(chunk) == _requested.end()) {
+                _requested[chunk] = true;
+                requests.push_back(chunk);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock{_mutex};
+    for (auto it = _requests.begin(); it != _requests.end();) {
+        if (!inRange(*it, _radius)) {
+            _requested.erase(*it);
+            it = _requests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!requests.empty()) {
+        _requests.insert(_requests.end(), requests.begin(), requests.end());
+        _requestsAvailable.notify_one();
+    }
+}
+
+void SL::ChunkStreamer::wait() {
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _requestsComplete.wait(lock, [&] {
+            return _requests.empty() && !_loading;
+        });
+    }
+    integrateLoadedChunks();
+}
+
+int32_t SL::ChunkStreamer::tile(uint32_t x, uint32_t y) {
+    auto chunk = _resident.find(key(x / _chunkSize, y / _chunkSize));
+    if (chunk == _resident.end()) {
+        return 0;
+    }
+    return chunk->second[(y % _chunkSize) * _chunkSize + x % _chunkSize];
+}
+
+bool SL::ChunkStreamer::resident(uint32_t chunkX, uint32_t chunkY) {
+    return _resident.find(key(chunkX, chunkY)) != _resident.end();
+}
+
+size_t SL::ChunkStreamer::residentChunks() {
+    return _resident.size();
+}
+
+size_t SL::ChunkStreamer::capacity() {
+    return (2 * (_radius + 1) + 1) * (2 * (_radius + 1) + 1);
+}
+
+SL::ChunkStreamer::ChunkKey SL::ChunkStreamer::key(uint32_t chunkX, uint32_t chunkY) {
+    return (static_cast<ChunkKey>(chunkY) << 32) | chunkX;
+}
+
+bool SL::ChunkStreamer::inRange(ChunkKey key, uint32_t radius) {
+    uint32_t chunkX = static_cast<uint32_t>(key & 0xffffffff);
+    uint32_t chunkY = static_cast<uint32_t>(key >> 32);
+    uint32_t distanceX = chunkX > _focusChunkX ? chunkX - _focusChunkX : _focusChunkX - chunkX;
+    uint32_t distanceY = chunkY > _focusChunkY ? chunkY - _focusChunkY : _focusChunkY - chunkY;
+    return distanceX <= radius && distanceY <= radius;
+}
+
+void SL::ChunkStreamer::integrateLoadedChunks() {
+    std::deque<std::pair<ChunkKey, std::vector<uint32_t>>> loaded;
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        loaded.swap(_loaded);
+        std::swap(error, _error);
+    }
+
+    for (auto &chunk : loaded) {
+        _requested.erase(chunk.first);
+        if (!chunk.second.empty() && inRange(chunk.first, _radius + 1)) {
+            _resident[chunk.first] = std::move(chunk.second);
+        }
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void SL::ChunkStreamer::load() {
+    std::unique_lock<std::mutex> lock{_mutex};
+    while (true) {
+        _requestsAvailable.wait(lock, [&] {
+            return !_requests.empty() || !_alive;
+        });
+
+        if (!_alive) {
+            return;
+        }
+
+        ChunkKey chunk = _requests.front();
+        _requests.pop_front();
+        _loading = true;
+
+        lock.unlock();
+        std::vector<uint32_t> tiles;
+        std::exception_ptr error;
+        try {
+            tiles = _loader(static_cast<uint32_t>(chunk & 0xffffffff), static_cast<uint32_t>(chunk >> 32));
+            tiles.resize(_chunkSize * _chunkSize, 0);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        // A chunk that failed to load comes back without tiles, so focusing on it again retries it
+        if (error) {
+            _error = error;
+        }
+        _loaded.emplace_back(chunk, std::move(tiles));
+        _loading = false;
+        _requestsComplete.notify_all();
+    }
+}
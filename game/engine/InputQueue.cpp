@@ -0,0 +1,34 @@
+#include "engine.h"
+
+SL::InputQueue::InputQueue(size_t capacity) : _capacity{capacity} {
+    _events.reserve(capacity);
+}
+
+void SL::InputQueue::clear() {
+    _events.clear();
+    _tick++;
+}
+
+bool SL::InputQueue::push(SL::InputEvent event) {
+    if (_events.size() == _capacity) {
+        return false;
+    }
+
+    _events.push_back(event);
+    return true;
+}
+
+void SL::InputQueue::reserve(size_t capacity) {
+    if (capacity > _capacity) {
+        _capacity = capacity;
+        _events.reserve(capacity);
+    }
+}
+
+size_t SL::InputQueue::size() const {
+    return _events.size();
+}
+
+size_t SL::InputQueue::capacity() const {
+    return _capacity;
+}
@@ -0,0 +1,68 @@
+#include <stdexcept>
+
+#include "engine.h"
+
+namespace {
+    const char *const KeyNames[] = {"left", "right", "up", "down", "jump"};
+
+    SL::KeyType keyType(const std::string &name) {
+        for (size_t i = 0; i < sizeof(KeyNames) / sizeof(KeyNames[0]); i++) {
+            if (name == KeyNames[i]) {
+                return static_cast<SL::KeyType>(i);
+            }
+        }
+        throw std::domain_error("Unknown key in input recording: " + name);
+    }
+
+    SL::ActionType actionType(const std::string &name) {
+        if (name == "press") {
+            return SL::ActionType::Press;
+        } else if (name == "release") {
+            return SL::ActionType::Release;
+        }
+        throw std::domain_error("Unknown action in input recording: " + name);
+    }
+}
+
+SL::InputRecording SL::InputRecording::parse(const std::string &recordingJson) {
+    auto json = nlohmann::json::parse(recordingJson);
+
+    InputRecording recording;
+    recording.frameTimes = json["frames"].get<std::vector<long>>();
+
+    for (auto &event : json["keys"]) {
+        uint64_t frame = event["frame"].get<uint64_t>();
+        if (frame >= recording.frameTimes.size() || (!recording.keyEvents.empty() && frame < recording.keyEvents.back().frame)) {
+            throw std::domain_error("Input recording key events must be in frame order and within the recorded frames");
+        }
+        recording.keyEvents.push_back(KeyEvent{frame, keyType(event["key"].get<std::string>()), actionType(event["action"].get<std::string>())});
+    }
+
+    return recording;
+}
+
+void SL::InputRecording::write(std::ostream &out) const {
+    nlohmann::json json;
+    json["frames"] = frameTimes;
+    json["keys"] = nlohmann::json::array();
+
+    for (auto &event : keyEvents) {
+        json["keys"].push_back({{"frame",  event.frame},
+                                {"key",    KeyNames[static_cast<size_t>(event.key)]},
+                                {"action", event.action == ActionType::Press ? "press" : "release"}});
+    }
+
+    out << json.dump() << "\n";
+}
+
+void SL::InputRecorder::keyEvent(SL::KeyType key, SL::ActionType action) {
+    _recording.keyEvents.push_back(InputRecording::KeyEvent{_recording.frameTimes.size(), key, action});
+}
+
+void SL::InputRecorder::frame(long delta) {
+    _recording.frameTimes.push_back(delta);
+}
+
+const SL::InputRecording &SL::InputRecorder::recording() const {
+    return _recording;
+}
@@ -2,14 +2,59 @@
 
 SL::JSONSpriteFactory::JSONSpriteFactory(SL::Engine &engine) : _engine{engine} {}
 
-std::map<std::string, SL::Sprite> SL::JSONSpriteFactory::parse(const std::string &spritesJson) {
+namespace {
+    SL::Sprite createSprite(SL::Engine &engine, nlohmann::json &spriteObj) {
+        // Optional per-frame durations in milliseconds, the last one covering any remaining frames
+        std::vector<uint32_t> durations{};
+        if (spriteObj.find("durations") != spriteObj.end()) {
+            durations = spriteObj["durations"].get<std::vector<uint32_t>>();
+        }
+        SL::AnimationClip::Loop loop = spriteObj.find("loop") != spriteObj.end() && !spriteObj["loop"].get<bool>() ? SL::AnimationClip::Loop::Once
+                                                                                                                    : SL::AnimationClip::Loop::Repeat;
+
+        // Irregular sheets list each frame's rectangle, optionally with its own duration
+        if (spriteObj.find("frames") != spriteObj.end()) {
+            std::vector<SL::Rect> frames{};
+            for (auto &frame : spriteObj["frames"]) {
+                frames.push_back(SL::Rect{frame["x"].get<int32_t>(), frame["y"].get<int32_t>(), frame["w"].get<int32_t>(), frame["h"].get<int32_t>()});
+                if (frame.find("duration") != frame.end()) {
+                    durations.resize(frames.size() - 1, durations.empty() ? SL::AnimationClip::DefaultFrameDuration : durations.back());
+                    durations.push_back(frame["duration"].get<uint32_t>());
+                }
+            }
+            return SL::Sprite{engine.createClip(spriteObj["img"].get<std::string>(), std::move(frames), durations, loop)};
+        }
+
+        uint32_t count = spriteObj.find("count") != spriteObj.end() ? spriteObj["count"].get<uint32_t>() : UINT32_MAX;
+        return SL::Sprite{engine.createClip(spriteObj["img"].get<std::string>(), spriteObj["cw"].get<uint32_t>(), spriteObj["ch"].get<uint32_t>(), durations, loop, count)};
+    }
+}
+
+SL::SpriteRegistry SL::JSONSpriteFactory::parse(const std::string &spritesJson, const std::vector<std::string> &wellKnownNames) {
+    SL::StartupProfiler::Scope profile{_engine.startupProfiler(), "JSONSpriteFactory::parse", spritesJson.size()};
+
     nlohmann::json spriteJson = nlohmann::json::parse(spritesJson);
-    std::map<std::string, SL::Sprite> result{};
+    SL::SpriteRegistry result{};
+
+    for (auto &name : wellKnownNames) {
+        bool found = false;
+        for (auto &spriteObj : spriteJson["sprites"]) {
+            if (spriteObj["name"].get<std::string>() == name) {
+                result.add(name, createSprite(_engine, spriteObj));
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            throw std::domain_error("Sprite manifest is missing " + name);
+        }
+    }
 
     for (auto &spriteObj : spriteJson["sprites"]) {
         const std::string &spriteName = spriteObj["name"].get<std::string>();
-        const SL::Sprite &sprite = _engine.createSprite(spriteObj["img"].get<std::string>(), spriteObj["cw"].get<uint32_t>(), spriteObj["ch"].get<uint32_t>());
-        result.insert(std::pair<std::string, SL::Sprite>(spriteName, sprite));
+        if (!result.contains(spriteName)) {
+            result.add(spriteName, createSprite(_engine, spriteObj));
+        }
     }
 
     return result;
@@ -0,0 +1,40 @@
+#include "engine.h"
+
+SL::ObjectSpawner::ObjectSpawner(SL::Registry &registry) : _registry{registry} {
+}
+
+bool SL::ObjectSpawner::defines(const std::string &type) const {
+    return _kinds.find(type) != _kinds.end();
+}
+
+uint32_t SL::ObjectSpawner::spawn(const std::vector<SL::MapObject> &objects) {
+    std::unordered_map<SL::ComponentStorage *, size_t> components;
+    size_t entities = 0;
+    for (auto &object : objects) {
+        auto kind = _kinds.find(object.type);
+        if (kind == _kinds.end()) {
+            continue;
+        }
+        entities++;
+        for (auto pool : kind->second.pools) {
+            components[pool]++;
+        }
+    }
+
+    // Reused indices come first, so new indices never go past the current count plus the objects spawned
+    size_t entityIndices = _registry.indexCount() + entities;
+    _registry.reserve(entityIndices);
+    for (auto &pool : components) {
+        pool.first->reserve(pool.first->size() + pool.second, entityIndices);
+    }
+
+    uint32_t spawned = 0;
+    for (auto &object : objects) {
+        auto kind = _kinds.find(object.type);
+        if (kind != _kinds.end()) {
+            kind->second.factory(_registry, _registry.create(), object);
+            spawned++;
+        }
+    }
+    return spawned;
+}
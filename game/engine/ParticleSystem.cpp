@@ -0,0 +1,111 @@
+#include <algorithm>
+
+#include "engine.h"
+
+SL::ParticleSystem::ParticleSystem(SL::Gfx *gfx, SL::Image image, uint32_t cellWidth, uint32_t cellHeight, uint32_t capacity)
+        : _gfx{gfx}, _image{std::move(image)}, _cellWidth{cellWidth}, _cellHeight{cellHeight}, _x(capacity), _y(capacity), _velocityX(capacity),
+          _velocityY(capacity), _age(capacity), _lifetime(capacity), _frame(capacity) {
+    _frames = std::max(1u, _image.width() / cellWidth);
+    _quads.reserve(capacity);
+}
+
+bool SL::ParticleSystem::emit(float x, float y, float velocityX, float velocityY, float lifetime) {
+    // Written so that a NaN lifetime is turned away too
+    if (_size == capacity() || !(lifetime > 0.0f)) {
+        return false;
+    }
+
+    _x[_size] = x;
+    _y[_size] = y;
+    _velocityX[_size] = velocityX;
+    _velocityY[_size] = velocityY;
+    _age[_size] = 0.0f;
+    _lifetime[_size] = lifetime;
+    _frame[_size] = 0;
+    _size++;
+    return true;
+}
+
+void SL::ParticleSystem::gravity(float pixelsPerSecondSquared) {
+    _gravity = pixelsPerSecondSquared;
+}
+
+void SL::ParticleSystem::update(long timeDelta) {
+    const float milliseconds = static_cast<float>(timeDelta);
+    const float seconds = milliseconds / 1000.0f;
+    const float gravity = _gravity * seconds;
+    const float frames = static_cast<float>(_frames);
+    const uint32_t count = _size;
+
+    float *x = _x.data();
+    float *y = _y.data();
+    float *velocityX = _velocityX.data();
+    float *velocityY = _velocityY.data();
+    float *age = _age.data();
+    const float *lifetime = _lifetime.data();
+    uint16_t *frame = _frame.data();
+
+    for (uint32_t i = 0; i < count; i++) {
+        velocityY[i] += gravity;
+        x[i] += velocityX[i] * seconds;
+        y[i] += velocityY[i] * seconds;
+        age[i] += milliseconds;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        float progress = std::min(age[i] / lifetime[i], 1.0f);
+        frame[i] = static_cast<uint16_t>(std::min(progress * frames, frames - 1.0f));
+    }
+
+    // The last live particle fills each hole, which is checked again before moving on
+    uint32_t i = 0;
+    while (i < _size) {
+        if (age[i] < lifetime[i]) {
+            i++;
+            continue;
+        }
+
+        uint32_t last = --_size;
+        x[i] = x[last];
+        y[i] = y[last];
+        velocityX[i] = velocityX[last];
+        velocityY[i] = velocityY[last];
+        age[i] = age[last];
+        _lifetime[i] = lifetime[last];
+        frame[i] = frame[last];
+    }
+}
+
+void SL::ParticleSystem::draw(int32_t offsetX, int32_t offsetY) {
+    _quads.resize(_size);
+    const int32_t width = static_cast<int32_t>(_cellWidth);
+    const int32_t height = static_cast<int32_t>(_cellHeight);
+
+    for (uint32_t i = 0; i < _size; i++) {
+        _quads[i] = Quad{static_cast<int32_t>(_x[i]) + offsetX, static_cast<int32_t>(_y[i]) + offsetY, _frame[i] * width, 0, width, height};
+    }
+
+    if (_size > 0) {
+        _gfx->drawQuads(_image, _quads);
+    }
+}
+
+uint32_t SL::ParticleSystem::size() const {
+    return _size;
+}
+
+uint32_t SL::ParticleSystem::capacity() const {
+    return static_cast<uint32_t>(_x.size());
+}
+
+float SL::ParticleSystem::x(uint32_t particle) const {
+    return _x[particle];
+}
+
+float SL::ParticleSystem::y(uint32_t particle) const {
+    return _y[particle];
+}
+
+uint16_t SL::ParticleSystem::frame(uint32_t particle) const {
+    return _frame[particle];
+}
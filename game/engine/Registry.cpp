@@ -0,0 +1,53 @@
+#include "engine.h"
+
+uint32_t SL::Registry::nextComponentId() {
+    static uint32_t nextId = 0;
+    return nextId++;
+}
+
+SL::Entity SL::Registry::create() {
+    if (!_freeIndices.empty()) {
+        uint32_t index = _freeIndices.back();
+        _freeIndices.pop_back();
+        return Entity{index, _generations[index]};
+    }
+
+    _generations.push_back(0);
+    return Entity{static_cast<uint32_t>(_generations.size() - 1), 0};
+}
+
+void SL::Registry::destroy(SL::Entity entity) {
+    if (!alive(entity)) {
+        return;
+    }
+
+    for (auto &pool : _pools) {
+        if (pool) {
+            pool->remove(entity.index);
+        }
+    }
+
+    _generations[entity.index]++;
+    _freeIndices.push_back(entity.index);
+}
+
+bool SL::Registry::alive(SL::Entity entity) const {
+    return entity.index < _generations.size() && _generations[entity.index] == entity.generation;
+}
+
+SL::Entity SL::Registry::entity(uint32_t index) const {
+    return Entity{index, _generations[index]};
+}
+
+size_t SL::Registry::size() const {
+    return _generations.size() - _freeIndices.size();
+}
+
+size_t SL::Registry::indexCount() const {
+    return _generations.size();
+}
+
+void SL::Registry::reserve(size_t entities) {
+    _generations.reserve(entities);
+    _freeIndices.reserve(entities);
+}
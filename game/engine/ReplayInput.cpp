@@ -0,0 +1,63 @@
+#include "engine.h"
+
+SL::ReplayInput::ReplayInput(SL::InputRecording recording) : _recording{std::move(recording)} {
+
+}
+
+void SL::ReplayInput::update() {
+    _events.clear();
+
+    if (finished()) {
+        if (_quitHandler) {
+            _quitHandler();
+        }
+        return;
+    }
+
+    // The clock holds still for the whole frame, so the engine sees exactly the recorded delta
+    _currentTime += _recording.frameTimes[_frame];
+
+    while (_nextKeyEvent < _recording.keyEvents.size() && _recording.keyEvents[_nextKeyEvent].frame == _frame) {
+        auto &event = _recording.keyEvents[_nextKeyEvent++];
+        SL::InputEvent queued{event.key, event.action, static_cast<uint64_t>(_currentTime) * 1000};
+        if (!_events.push(queued)) {
+            _events.reserve(_events.capacity() * 2);
+            _events.push(queued);
+        }
+
+        for (auto &keyHandler : _keyHandlers) {
+            keyHandler(event.key, event.action);
+        }
+    }
+
+    _frame++;
+
+    // The recorded session ended during its last frame, which the engine still finishes
+    if (finished() && _quitHandler) {
+        _quitHandler();
+    }
+}
+
+void SL::ReplayInput::addKeyHandler(std::function<void(SL::KeyType, SL::ActionType)> keyHandler) {
+    _keyHandlers.push_back(std::move(keyHandler));
+}
+
+void SL::ReplayInput::addQuitHandler(std::function<void()> quitHandler) {
+    _quitHandler = std::move(quitHandler);
+}
+
+const SL::InputQueue &SL::ReplayInput::events() const {
+    return _events;
+}
+
+long SL::ReplayInput::currentTime() {
+    return _currentTime;
+}
+
+void SL::ReplayInput::sleep(long) {
+
+}
+
+bool SL::ReplayInput::finished() const {
+    return _frame >= _recording.frameTimes.size();
+}
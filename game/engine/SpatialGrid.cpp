@@ -0,0 +1,139 @@
+#include <cmath>
+
+#include "engine.h"
+
+SL::SpatialGrid::SpatialGrid(uint32_t tilesPerCell) : _cellSize{tilesPerCell * 16.0} {
+
+}
+
+void SL::SpatialGrid::insert(uint32_t id, double x, double y, double width, double height) {
+    if (id >= _entries.size()) {
+        _entries.resize(id + 1, Entry{0, 0, 0, 0, 0, 0, 0, 0, 0, false});
+    }
+
+    Entry &entry = _entries[id];
+    if (entry.present) {
+        move(id, x, y, width, height);
+        return;
+    }
+
+    entry = {x, y, width, height, cellAt(x), cellAt(y), cellAt(x + width), cellAt(y + height), 0, true};
+    link(id);
+    _size++;
+}
+
+void SL::SpatialGrid::move(uint32_t id, double x, double y, double width, double height) {
+    if (id >= _entries.size() || !_entries[id].present) {
+        return;
+    }
+
+    Entry &entry = _entries[id];
+    entry.x = x;
+    entry.y = y;
+    entry.width = width;
+    entry.height = height;
+
+    int32_t left = cellAt(x);
+    int32_t top = cellAt(y);
+    int32_t right = cellAt(x + width);
+    int32_t bottom = cellAt(y + height);
+
+    // Moving within the same cells is the common case and doesn't need the cell lists touching
+    if (left == entry.left && top == entry.top && right == entry.right && bottom == entry.bottom) {
+        return;
+    }
+
+    unlink(id);
+    entry.left = left;
+    entry.top = top;
+    entry.right = right;
+    entry.bottom = bottom;
+    link(id);
+}
+
+void SL::SpatialGrid::remove(uint32_t id) {
+    if (id >= _entries.size() || !_entries[id].present) {
+        return;
+    }
+
+    unlink(id);
+    _entries[id].present = false;
+    _size--;
+}
+
+void SL::SpatialGrid::query(double x, double y, double width, double height, std::vector<uint32_t> &results) {
+    // Entities spanning several cells are only reported once per query
+    _queryStamp++;
+
+    for (int32_t cellY = cellAt(y); cellY <= cellAt(y + height); cellY++) {
+        for (int32_t cellX = cellAt(x); cellX <= cellAt(x + width); cellX++) {
+            auto cell = _cells.find(cellKey(cellX, cellY));
+            if (cell == _cells.end()) {
+                continue;
+            }
+
+            for (uint32_t id : cell->second) {
+                Entry &entry = _entries[id];
+                if (entry.queryStamp == _queryStamp) {
+                    continue;
+                }
+                entry.queryStamp = _queryStamp;
+
+                if (entry.x < x + width && x < entry.x + entry.width && entry.y < y + height && y < entry.y + entry.height) {
+                    results.push_back(id);
+                }
+            }
+        }
+    }
+}
+
+size_t SL::SpatialGrid::size() {
+    return _size;
+}
+
+size_t SL::SpatialGrid::occupiedCells() {
+    return _cells.size();
+}
+
+uint64_t SL::SpatialGrid::cellKey(int32_t cellX, int32_t cellY) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cellY)) << 32) | static_cast<uint32_t>(cellX);
+}
+
+int32_t SL::SpatialGrid::cellAt(double position) {
+    return static_cast<int32_t>(std::floor(position / _cellSize));
+}
+
+void SL::SpatialGrid::link(uint32_t id) {
+    Entry &entry = _entries[id];
+    for (int32_t cellY = entry.top; cellY <= entry.bottom; cellY++) {
+        for (int32_t cellX = entry.left; cellX <= entry.right; cellX++) {
+            _cells[cellKey(cellX, cellY)].push_back(id);
+        }
+    }
+}
+
+void SL::SpatialGrid::unlink(uint32_t id) {
+    Entry &entry = _entries[id];
+    for (int32_t cellY = entry.top; cellY <= entry.bottom; cellY++) {
+        for (int32_t cellX = entry.left; cellX <= entry.right; cellX++) {
+            auto cell = _cells.find(cellKey(cellX, cellY));
+            if (cell == _cells.end()) {
+                continue;
+            }
+
+            std::vector<uint32_t> &ids = cell->second;
+            for (size_t i = 0; i < ids.size(); i++) {
+                if (ids[i] == id) {
+                    ids[i] = ids.back();
+                    ids.pop_back();
+                    break;
+                }
+            }
+
+            // Cells are dropped once empty so that entities roaming the map don't leave a trail of them behind
+            if (ids.empty()) {
+                _cells.erase(cell);
+            }
+        }
+    }
+}
@@ -1,24 +1,42 @@
 #include "engine.h"
 
-SL::Sprite::Sprite(SL::Gfx *gfx, SL::Image image, uint32_t cellWidth, uint32_t cellHeight) : _gfx{gfx}, _image{image}, _cellWidth{cellWidth}, _cellHeight{cellHeight} {
-    _frames = (image.width() / cellWidth) * (image.height() / cellHeight);
+SL::Sprite::Sprite(SL::Gfx *gfx, SL::Image image, uint32_t cellWidth, uint32_t cellHeight)
+        : Sprite(std::make_shared<AnimationClip>(gfx, std::move(image), cellWidth, cellHeight)) {
+}
+
+SL::Sprite::Sprite(std::shared_ptr<SL::AnimationClip> clip) : _clip{std::move(clip)}, _playback{_clip.get(), 0, 0, false} {
 }
 
 void SL::Sprite::draw(int32_t x, int32_t y, bool horizontallyFlipped) {
-    _gfx->drawImage(_image, x, y, _frame * _cellWidth, 0, _cellWidth, _cellHeight, horizontallyFlipped);
+    _playback.draw(x, y, horizontallyFlipped);
+}
+
+void SL::Sprite::drawFrame(uint32_t frame, int32_t x, int32_t y, bool horizontallyFlipped) {
+    _clip->draw(frame, x, y, horizontallyFlipped);
 }
 
 uint32_t SL::Sprite::frameCount() {
-    return _frames;
+    return _clip->frameCount();
 }
 
 void SL::Sprite::update(long timeDelta) {
-    _lastTicks += timeDelta;
-    if (_lastTicks >= 83L) {
-        _lastTicks -= 83L;
-        _frame++;
-        if (_frame >= frameCount()) {
-            _frame = 0;
-        }
+    _playback.advance(timeDelta);
+}
+
+bool SL::Sprite::reload(const SL::Sprite &updated) {
+    if (*_clip == *updated._clip) {
+        return false;
     }
-}
\ No newline at end of file
+
+    *_clip = *updated._clip;
+
+    if (_playback.frame >= _clip->frameCount()) {
+        _playback = AnimationPlayback{_clip.get(), 0, 0, false};
+    }
+
+    return true;
+}
+
+const std::shared_ptr<SL::AnimationClip> &SL::Sprite::clip() const {
+    return _clip;
+}
@@ -0,0 +1,39 @@
+#include "engine.h"
+
+SL::SpriteId SL::SpriteRegistry::add(const std::string &name, SL::Sprite sprite) {
+    auto existing = _ids.find(name);
+    if (existing != _ids.end()) {
+        _sprites[existing->second] = std::move(sprite);
+        return existing->second;
+    }
+
+    if (_sprites.size() >= UINT16_MAX) {
+        throw std::domain_error("Too many sprites to add " + name);
+    }
+
+    SpriteId id = static_cast<SpriteId>(_sprites.size());
+    _sprites.push_back(std::move(sprite));
+    _names.push_back(name);
+    _ids.insert({name, id});
+    return id;
+}
+
+bool SL::SpriteRegistry::contains(const std::string &name) const {
+    return _ids.find(name) != _ids.end();
+}
+
+SL::SpriteId SL::SpriteRegistry::id(const std::string &name) const {
+    auto existing = _ids.find(name);
+    if (existing == _ids.end()) {
+        throw std::domain_error("Unknown sprite " + name);
+    }
+    return existing->second;
+}
+
+const std::string &SL::SpriteRegistry::name(SL::SpriteId id) const {
+    return _names[id];
+}
+
+size_t SL::SpriteRegistry::size() const {
+    return _sprites.size();
+}
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "engine.h"
+
+SL::StartupProfiler::Scope::Scope(SL::StartupProfiler *profiler, std::string label, uint64_t bytes) : _profiler{profiler}, _label{std::move(label)}, _bytes{bytes},
+                                                                                                     _startMicros{profiler != nullptr ? profiler->elapsedMicros() : 0} {
+
+}
+
+SL::StartupProfiler::Scope::~Scope() {
+    if (_profiler != nullptr) {
+        _profiler->record(_label, _startMicros, _profiler->elapsedMicros() - _startMicros, _bytes);
+    }
+}
+
+void SL::StartupProfiler::Scope::addBytes(uint64_t bytes) {
+    _bytes += bytes;
+}
+
+SL::StartupProfiler::StartupProfiler() : _start{std::chrono::steady_clock::now()} {
+
+}
+
+uint64_t SL::StartupProfiler::elapsedMicros() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count());
+}
+
+void SL::StartupProfiler::record(const std::string &label, uint64_t startMicros, uint64_t durationMicros, uint64_t bytes) {
+    _entries.push_back({label, startMicros, durationMicros, bytes});
+}
+
+std::vector<SL::StartupProfiler::Entry> SL::StartupProfiler::entries() {
+    std::vector<Entry> sorted{_entries};
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Entry &a, const Entry &b) {
+        return a.durationMicros > b.durationMicros;
+    });
+    return sorted;
+}
+
+void SL::StartupProfiler::report(std::ostream &out) {
+    out << "Startup profile, " << std::fixed << std::setprecision(2) << elapsedMicros() / 1000.0 << " ms total\n";
+    out << std::setw(12) << "ms" << std::setw(12) << "start ms" << std::setw(12) << "bytes" << "  label\n";
+
+    for (auto &entry : entries()) {
+        out << std::setw(12) << entry.durationMicros / 1000.0
+            << std::setw(12) << entry.startMicros / 1000.0
+            << std::setw(12) << entry.bytes
+            << "  " << entry.label << "\n";
+    }
+}
+
+void SL::StartupProfiler::reportJSON(std::ostream &out) {
+    nlohmann::json report;
+    report["totalMicros"] = elapsedMicros();
+    report["entries"] = nlohmann::json::array();
+
+    for (auto &entry : entries()) {
+        report["entries"].push_back({{"label",          entry.label},
+                                     {"startMicros",    entry.startMicros},
+                                     {"durationMicros", entry.durationMicros},
+                                     {"bytes",          entry.bytes}});
+    }
+
+    out << report.dump(2) << "\n";
+}
@@ -0,0 +1,117 @@
+#include <stdexcept>
+#include <cstring>
+
+#include <zlib.h>
+
+#ifdef SL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "engine.h"
+
+namespace {
+    const uint8_t INVALID = 0xff;
+
+    struct Base64Table {
+        uint8_t values[256];
+
+        Base64Table() {
+            std::memset(values, INVALID, sizeof(values));
+            const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (uint8_t i = 0; i < 64; i++) {
+                values[static_cast<uint8_t>(alphabet[i])] = i;
+            }
+        }
+    };
+
+    std::vector<uint8_t> decodeBase64(const std::string &data) {
+        static const Base64Table table{};
+
+        std::vector<uint8_t> bytes;
+        bytes.reserve(data.size() / 4 * 3);
+
+        uint32_t accumulator = 0;
+        uint32_t bits = 0;
+        for (char c : data) {
+            uint8_t value = table.values[static_cast<uint8_t>(c)];
+            if (value == INVALID) {
+                // Padding and the whitespace Tiled wraps long layers with carry no data
+                continue;
+            }
+            accumulator = (accumulator << 6) | value;
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                bytes.push_back(static_cast<uint8_t>(accumulator >> bits));
+            }
+        }
+
+        return bytes;
+    }
+
+    void inflateInto(const std::vector<uint8_t> &compressed, uint8_t *out, size_t outSize) {
+        z_stream stream{};
+        // 32 added to the window bits lets zlib detect both zlib and gzip headers
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            throw std::domain_error("Failed to initialise zlib");
+        }
+
+        stream.next_in = const_cast<Bytef *>(compressed.data());
+        stream.avail_in = static_cast<uInt>(compressed.size());
+        stream.next_out = out;
+        stream.avail_out = static_cast<uInt>(outSize);
+
+        int result = inflate(&stream, Z_FINISH);
+        size_t inflated = stream.total_out;
+        inflateEnd(&stream);
+
+        if (result != Z_STREAM_END || inflated != outSize) {
+            throw std::domain_error("Failed to decompress tile layer data");
+        }
+    }
+
+    void decompressZstdInto(const std::vector<uint8_t> &compressed, uint8_t *out, size_t outSize) {
+#ifdef SL_HAVE_ZSTD
+        size_t result = ZSTD_decompress(out, outSize, compressed.data(), compressed.size());
+        if (ZSTD_isError(result) || result != outSize) {
+            throw std::domain_error("Failed to decompress tile layer data");
+        }
+#else
+        (void) compressed;
+        (void) out;
+        (void) outSize;
+        throw std::domain_error("zstd compressed tile layers are not supported by this build");
+#endif
+    }
+}
+
+std::vector<uint32_t> SL::decodeTileData(const std::string &data, const std::string &compression, uint32_t tileCount) {
+    std::vector<uint8_t> bytes = decodeBase64(data);
+    std::vector<uint32_t> tiles(tileCount);
+    uint8_t *out = reinterpret_cast<uint8_t *>(tiles.data());
+    size_t outSize = tiles.size() * sizeof(uint32_t);
+
+    if (compression.empty()) {
+        if (bytes.size() != outSize) {
+            throw std::domain_error("Tile layer data does not match layer size");
+        }
+        std::memcpy(out, bytes.data(), outSize);
+    } else if (compression == "zlib" || compression == "gzip") {
+        inflateInto(bytes, out, outSize);
+    } else if (compression == "zstd") {
+        decompressZstdInto(bytes, out, outSize);
+    } else {
+        throw std::domain_error("Unknown tile layer compression: " + compression);
+    }
+
+    // Tiled stores gids little endian, which is already the host order almost everywhere
+    const uint32_t probe = 1;
+    if (*reinterpret_cast<const uint8_t *>(&probe) != 1) {
+        for (auto &tile : tiles) {
+            const uint8_t *b = reinterpret_cast<const uint8_t *>(&tile);
+            tile = static_cast<uint32_t>(b[0]) | static_cast<uint32_t>(b[1]) << 8 | static_cast<uint32_t>(b[2]) << 16 | static_cast<uint32_t>(b[3]) << 24;
+        }
+    }
+
+    return tiles;
+}
@@ -1,15 +1,58 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
 #include "engine.h"
 
-SL::Tilemap::Tilemap(uint32_t width, uint32_t height, std::vector<Layer> layers, int32_t playerSpawnX, int32_t playerSpawnY, int32_t cameraSpawnX, int32_t cameraSpawnY, Image bgImage, Image mgImage)
-        : _w{width}, _h{height}, _layers{std::move(layers)}, _playerSpawnX{playerSpawnX}, _playerSpawnY{playerSpawnY}, _cameraSpawnX{cameraSpawnX}, _cameraSpawnY{cameraSpawnY}, _bgImage{
-        std::move(bgImage)}, _mgImage{std::move(mgImage)} {
+SL::Tilemap::Tilemap(uint32_t width, uint32_t height, std::vector<Layer> layers, int32_t collisionLayer, std::vector<TileShape> tileShapes, int32_t playerSpawnX, int32_t playerSpawnY,
+                     int32_t cameraSpawnX, int32_t cameraSpawnY, Image bgImage, Image mgImage, std::vector<MapObject> objects)
+        : _w{width}, _h{height}, _layers{std::move(layers)}, _collisionLayer{collisionLayer}, _tileShapes{std::move(tileShapes)}, _playerSpawnX{playerSpawnX}, _playerSpawnY{playerSpawnY}, _cameraSpawnX{cameraSpawnX},
+          _cameraSpawnY{cameraSpawnY}, _bgImage{std::move(bgImage)}, _mgImage{std::move(mgImage)},
+          _objects{std::move(objects)} {
+    buildCollision();
+}
+
+void SL::Tilemap::buildCollision() {
+    _streamedCollision = _collisionLayer >= 0 && _layers[_collisionLayer].streamer() != nullptr;
+    if (_streamedCollision) {
+        _collisionStride = 0;
+        _collision.clear();
+        _shapedCollision.clear();
+        return;
+    }
+
+    _collisionStride = (_w + 63) / 64;
+    _collision.assign(_collisionStride * _h, 0);
+    _shapedCollision.assign(_collisionStride * _h, 0);
 
+    if (_collisionLayer < 0) {
+        return;
+    }
+
+    Layer &collision = _layers[_collisionLayer];
+    for (uint32_t ty = 0; ty < _h; ty++) {
+        for (uint32_t tx = 0; tx < _w; tx++) {
+            uint32_t tile = static_cast<uint32_t>(collision.tile(tx, ty));
+            if (tile == 0) {
+                continue;
+            }
+
+            bool fullySolid = tile >= _tileShapes.size() || _tileShapes[tile].type == TileShape::Solid;
+            std::vector<uint64_t> &bits = fullySolid ? _collision : _shapedCollision;
+            bits[ty * _collisionStride + tx / 64] |= uint64_t{1} << (tx % 64);
+        }
+    }
 }
 
 SL::Tilemap::Layer &SL::Tilemap::layer(uint32_t index) {
     return _layers[index];
 }
 
+int32_t SL::Tilemap::collisionLayer() {
+    return _collisionLayer;
+}
+
 uint32_t SL::Tilemap::width() {
     return _w;
 }
@@ -42,12 +85,16 @@ SL::Image &SL::Tilemap::mgImage() {
     return _mgImage;
 }
 
+const std::vector<SL::MapObject> &SL::Tilemap::objects() const {
+    return _objects;
+}
+
 bool SL::Tilemap::checkCollisionDown(double x, double &y, double travelSpeed) {
 
-    uint32_t tx = static_cast<uint32_t>(x / 16);
-    uint32_t ty = static_cast<uint32_t>((y + travelSpeed) / 16);
+    int32_t tx = static_cast<int32_t>(x / 16);
+    int32_t ty = static_cast<int32_t>((y + travelSpeed) / 16);
 
-    if (layer(2).tile(tx, ty) != 0) {
+    if (solid(tx, ty)) {
         y = ty * 16;
         return true;
     }
@@ -56,10 +103,10 @@ bool SL::Tilemap::checkCollisionDown(double x, double &y, double travelSpeed) {
 }
 
 bool SL::Tilemap::checkCollisionRight(double &x, double y, double travelSpeed) {
-    uint32_t tx = static_cast<uint32_t>((x+travelSpeed) / 16);
-    uint32_t ty = static_cast<uint32_t>(y / 16);
+    int32_t tx = static_cast<int32_t>((x+travelSpeed) / 16);
+    int32_t ty = static_cast<int32_t>(y / 16);
 
-    if (layer(2).tile(tx, ty) != 0) {
+    if (solid(tx, ty)) {
         x = tx * 16;
         return true;
     }
@@ -68,10 +115,10 @@ bool SL::Tilemap::checkCollisionRight(double &x, double y, double travelSpeed) {
 }
 
 bool SL::Tilemap::checkCollisionLeft(double &x, double y, double travelSpeed) {
-    uint32_t tx = static_cast<uint32_t>((x+travelSpeed) / 16);
-    uint32_t ty = static_cast<uint32_t>(y / 16);
+    int32_t tx = static_cast<int32_t>((x+travelSpeed) / 16);
+    int32_t ty = static_cast<int32_t>(y / 16);
 
-    if (layer(2).tile(tx, ty) != 0) {
+    if (solid(tx, ty)) {
         x = (tx+1) * 16;
         return true;
     }
@@ -80,10 +127,10 @@ bool SL::Tilemap::checkCollisionLeft(double &x, double y, double travelSpeed) {
 }
 
 bool SL::Tilemap::checkCollisionUp(double x, double &y, double travelSpeed) {
-    uint32_t tx = static_cast<uint32_t>(x / 16);
-    uint32_t ty = static_cast<uint32_t>((y + travelSpeed) / 16);
+    int32_t tx = static_cast<int32_t>(x / 16);
+    int32_t ty = static_cast<int32_t>((y + travelSpeed) / 16);
 
-    if (layer(2).tile(tx, ty) != 0) {
+    if (solid(tx, ty)) {
         y = (ty+1) * 16;
         return true;
     }
@@ -91,30 +138,561 @@ bool SL::Tilemap::checkCollisionUp(double x, double &y, double travelSpeed) {
     return false;
 }
 
-SL::Tilemap::Layer::Layer(Gfx *gfx, Image tileset, uint32_t width, uint32_t height, std::vector<uint32_t> tiles) : _gfx{gfx}, _tileset{std::move(tileset)}, _w{width}, _h{height}, _tiles{
-        std::move(tiles)} {
+bool SL::Tilemap::solid(int32_t tileX, int32_t tileY) {
+    if (tileX < 0 || tileY < 0 || tileX >= static_cast<int32_t>(_w) || tileY >= static_cast<int32_t>(_h)) {
+        return false;
+    }
+    if (_streamedCollision) {
+        uint32_t tile = static_cast<uint32_t>(_layers[_collisionLayer].tile(static_cast<uint32_t>(tileX), static_cast<uint32_t>(tileY)));
+        return tile != 0 && (tile >= _tileShapes.size() || _tileShapes[tile].type == TileShape::Solid);
+    }
+    return (_collision[tileY * _collisionStride + tileX / 64] >> (tileX % 64)) & 1;
 }
 
-int32_t SL::Tilemap::Layer::tile(uint32_t x, uint32_t y) {
-    return _tiles[y * _w + x];
+// Whether the tile is a one way platform or slope
+bool SL::Tilemap::shaped(int32_t tileX, int32_t tileY) {
+    if (_streamedCollision) {
+        uint32_t tile = static_cast<uint32_t>(_layers[_collisionLayer].tile(static_cast<uint32_t>(tileX), static_cast<uint32_t>(tileY)));
+        return tile != 0 && tile < _tileShapes.size() && _tileShapes[tile].type != TileShape::Solid;
+    }
+    return (_shapedCollision[tileY * _collisionStride + tileX / 64] >> (tileX % 64)) & 1;
 }
 
-void SL::Tilemap::Layer::draw(int32_t x, int32_t y) {
+SL::TileShape SL::Tilemap::shape(int32_t tileX, int32_t tileY) {
+    uint32_t tile = static_cast<uint32_t>(_layers[_collisionLayer].tile(static_cast<uint32_t>(tileX), static_cast<uint32_t>(tileY)));
+    return tile < _tileShapes.size() ? _tileShapes[tile] : TileShape{TileShape::Solid, 0, 0};
+}
 
-    for (uint32_t ty = 0; ty < _h; ty++) {
-        for (uint32_t tx = 0; tx < _w; tx++) {
-            drawTile(tx, ty, x + tx * 16, y + ty * 16);
+bool SL::Tilemap::landOnShapes(int32_t row, int32_t left, int32_t right, double centerX, double previousBottom, double &bottom) {
+    if (row < 0 || row >= static_cast<int32_t>(_h)) {
+        return false;
+    }
+
+    left = std::max(left, 0);
+    right = std::min(right, static_cast<int32_t>(_w) - 1);
+
+    for (int32_t column = left; column <= right; column++) {
+        if (!shaped(column, row)) {
+            continue;
+        }
+
+        TileShape tileShape = shape(column, row);
+        double tileTop = row * 16.0;
+
+        if (tileShape.type == TileShape::OneWay) {
+            // Platforms only catch boxes that start the move above them
+            if (previousBottom <= tileTop && bottom >= tileTop) {
+                bottom = tileTop;
+                return true;
+            }
+        } else if (column == static_cast<int32_t>(std::floor(centerX / 16))) {
+            // Slopes are stood on at the middle of the box, and anything that started the move inside the
+            // slope's tile is lifted onto its surface so that walking uphill climbs it.
+            double along = std::min(std::max(centerX - column * 16.0, 0.0), 16.0) / 16.0;
+            double surface = tileTop + tileShape.leftSurface + (tileShape.rightSurface - tileShape.leftSurface) * along;
+            if (previousBottom <= tileTop + 16.0 && bottom >= surface) {
+                bottom = surface;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool SL::Tilemap::solidRow(int32_t tileY, int32_t fromTileX, int32_t toTileX) {
+    if (tileY < 0 || tileY >= static_cast<int32_t>(_h)) {
+        return false;
+    }
+
+    fromTileX = std::max(fromTileX, 0);
+    toTileX = std::min(toTileX, static_cast<int32_t>(_w) - 1);
+    if (fromTileX > toTileX) {
+        return false;
+    }
+
+    if (_streamedCollision) {
+        for (int32_t tileX = fromTileX; tileX <= toTileX; tileX++) {
+            if (solid(tileX, tileY)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Scans 64 tiles at a time, masking off the ends of the span in the first and last words
+    const uint64_t *row = &_collision[tileY * _collisionStride];
+    uint32_t firstWord = static_cast<uint32_t>(fromTileX) / 64;
+    uint32_t lastWord = static_cast<uint32_t>(toTileX) / 64;
+    uint64_t firstMask = ~uint64_t{0} << (fromTileX % 64);
+    uint64_t lastMask = ~uint64_t{0} >> (63 - toTileX % 64);
+
+    if (firstWord == lastWord) {
+        return (row[firstWord] & firstMask & lastMask) != 0;
+    }
+
+    uint64_t any = row[firstWord] & firstMask;
+    for (uint32_t word = firstWord + 1; word < lastWord; word++) {
+        any |= row[word];
+    }
+    any |= row[lastWord] & lastMask;
+
+    return any != 0;
+}
+
+bool SL::Tilemap::solidColumn(int32_t tileX, int32_t fromTileY, int32_t toTileY) {
+    fromTileY = std::max(fromTileY, 0);
+    toTileY = std::min(toTileY, static_cast<int32_t>(_h) - 1);
+    for (int32_t tileY = fromTileY; tileY <= toTileY; tileY++) {
+        if (solid(tileX, tileY)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+    int32_t tileAt(double position) {
+        return static_cast<int32_t>(std::floor(position / 16));
+    }
+
+    // The tile holding the far edge of a span, edges sitting exactly on a tile boundary don't overlap the next tile
+    int32_t tileBefore(double position) {
+        return static_cast<int32_t>(std::ceil(position / 16)) - 1;
+    }
+}
+
+// A box standing in a slope's tile sits partly below the top of its row, so solid ground level with the top of the
+// slope would stop it like a wall. Lifts it onto that ground instead when there is room above.
+bool SL::Tilemap::stepUp(int32_t column, int32_t centerColumn, int32_t left, int32_t right, double height, SL::Tilemap::Sweep &result, int32_t &top,
+                         int32_t &bottom) {
+    if (bottom < 0 || bottom >= static_cast<int32_t>(_h) || centerColumn < 0 || centerColumn >= static_cast<int32_t>(_w) ||
+        !shaped(centerColumn, bottom) || shape(centerColumn, bottom).type != TileShape::Slope) {
+        return false;
+    }
+
+    double steppedY = bottom * 16.0 - height;
+    int32_t steppedTop = tileAt(steppedY);
+    if (solidColumn(column, steppedTop, bottom - 1) || (steppedTop < top && solidRow(steppedTop, left, right))) {
+        return false;
+    }
+
+    result.y = steppedY;
+    top = steppedTop;
+    bottom--;
+    return true;
+}
+
+SL::Tilemap::Sweep SL::Tilemap::sweep(double x, double y, double width, double height, double velocityX, double velocityY) {
+    Sweep result{x, y, 0};
+
+    // Movement is resolved one axis at a time, visiting every column then every row the box passes through
+    // so that no velocity can tunnel through a tile.
+    int32_t top = tileAt(result.y);
+    int32_t bottom = tileBefore(result.y + height);
+    int32_t centerColumn = tileAt(x + width / 2);
+    if (velocityX > 0) {
+        int32_t from = tileBefore(result.x + width) + 1;
+        int32_t to = tileBefore(result.x + width + velocityX);
+        result.x += velocityX;
+        for (int32_t column = from; column <= to; column++) {
+            if (solidColumn(column, top, bottom) && !stepUp(column, centerColumn, tileAt(x), from - 1, height, result, top, bottom)) {
+                result.x = column * 16 - width;
+                result.contacts |= ContactRight;
+                break;
+            }
         }
+    } else if (velocityX < 0) {
+        int32_t from = tileAt(result.x) - 1;
+        int32_t to = tileAt(result.x + velocityX);
+        result.x += velocityX;
+        for (int32_t column = from; column >= to; column--) {
+            if (solidColumn(column, top, bottom) && !stepUp(column, centerColumn, from + 1, tileBefore(x + width), height, result, top, bottom)) {
+                result.x = (column + 1) * 16;
+                result.contacts |= ContactLeft;
+                break;
+            }
+        }
+    }
+
+    int32_t left = tileAt(result.x);
+    int32_t right = tileBefore(result.x + width);
+    if (velocityY > 0) {
+        double previousBottom = result.y + height;
+        double bottom = previousBottom + velocityY;
+        double centerX = result.x + width / 2;
+        int32_t from = tileBefore(previousBottom);
+        int32_t to = tileBefore(bottom);
+        result.y += velocityY;
+        // The row the box's bottom starts in is checked too, so a box that begins the move inside solid ground is
+        // pushed back out onto it rather than sinking further
+        for (int32_t row = from; row <= to; row++) {
+            if (solidRow(row, left, right)) {
+                result.y = row * 16 - height;
+                result.contacts |= ContactDown;
+                break;
+            }
+            if (landOnShapes(row, left, right, centerX, previousBottom, bottom)) {
+                result.y = bottom - height;
+                result.contacts |= ContactDown;
+                break;
+            }
+        }
+    } else if (velocityY < 0) {
+        int32_t from = tileAt(result.y) - 1;
+        int32_t to = tileAt(result.y + velocityY);
+        result.y += velocityY;
+        for (int32_t row = from; row >= to; row--) {
+            if (solidRow(row, left, right)) {
+                result.y = (row + 1) * 16;
+                result.contacts |= ContactUp;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+void SL::Tilemap::sweep(SL::BodyBatch &bodies, uint32_t threads) {
+    // Threads are only worth starting once each has a good number of bodies to resolve
+    const size_t minimumBodiesPerThread = 256;
+    size_t count = bodies.size();
+    threads = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(threads, count / minimumBodiesPerThread)));
+
+    if (threads == 1) {
+        sweepRange(bodies, 0, count);
+        return;
+    }
+
+    // Sweeping only reads the map, so each thread can resolve its own slice of the batch
+    std::vector<std::thread> workers;
+    size_t slice = (count + threads - 1) / threads;
+    for (uint32_t i = 1; i < threads; i++) {
+        workers.emplace_back(&Tilemap::sweepRange, this, std::ref(bodies), std::min(count, i * slice), std::min(count, (i + 1) * slice));
+    }
+    sweepRange(bodies, 0, std::min(count, slice));
+
+    for (auto &worker : workers) {
+        worker.join();
     }
 }
 
-void SL::Tilemap::Layer::drawTile(uint32_t tileX, uint32_t tileY, int32_t x, int32_t y) {
-    auto tileNumber = tile(tileX, tileY);
+void SL::Tilemap::sweepRange(SL::BodyBatch &bodies, size_t from, size_t to) {
+    double *x = bodies.x.data();
+    double *y = bodies.y.data();
+    const double *width = bodies.width.data();
+    const double *height = bodies.height.data();
+    const double *velocityX = bodies.velocityX.data();
+    const double *velocityY = bodies.velocityY.data();
+    uint8_t *contacts = bodies.contacts.data();
 
-    if (tileNumber > 0) {
-        tileNumber -= 1;
-        int32_t sourceX = tileNumber % (_tileset.width() / 16);
-        int32_t sourceY = tileNumber / (_tileset.width() / 16);
-        _gfx->drawImage(_tileset, x, y, sourceX * 16, sourceY * 16, 16, 16, false);
+    for (size_t i = from; i < to; i++) {
+        Sweep result = sweep(x[i], y[i], width[i], height[i], velocityX[i], velocityY[i]);
+        x[i] = result.x;
+        y[i] = result.y;
+        contacts[i] = result.contacts;
     }
-}
\ No newline at end of file
+}
+
+SL::Tilemap::RayHit SL::Tilemap::raycast(double originX, double originY, double directionX, double directionY, double maxDistance) {
+    RayHit result{false, 0, 0, originX, originY, 0, 0, 0.0};
+
+    double length = std::sqrt(directionX * directionX + directionY * directionY);
+    if (length == 0.0) {
+        return result;
+    }
+    directionX /= length;
+    directionY /= length;
+
+    int32_t tileX = tileAt(originX);
+    int32_t tileY = tileAt(originY);
+    if (solid(tileX, tileY)) {
+        result.hit = true;
+        result.tileX = tileX;
+        result.tileY = tileY;
+        return result;
+    }
+
+    // Walks the grid a tile at a time (Amanatides & Woo), always crossing whichever tile boundary the ray reaches first
+    int32_t stepX = directionX > 0 ? 1 : -1;
+    int32_t stepY = directionY > 0 ? 1 : -1;
+    const double infinity = std::numeric_limits<double>::infinity();
+    double deltaX = directionX != 0.0 ? std::abs(16.0 / directionX) : infinity;
+    double deltaY = directionY != 0.0 ? std::abs(16.0 / directionY) : infinity;
+    double nextX = directionX != 0.0 ? ((tileX + (stepX > 0 ? 1 : 0)) * 16.0 - originX) / directionX : infinity;
+    double nextY = directionY != 0.0 ? ((tileY + (stepY > 0 ? 1 : 0)) * 16.0 - originY) / directionY : infinity;
+
+    while (true) {
+        double distance;
+        int32_t normalX = 0;
+        int32_t normalY = 0;
+        if (nextX < nextY) {
+            distance = nextX;
+            nextX += deltaX;
+            tileX += stepX;
+            normalX = -stepX;
+        } else {
+            distance = nextY;
+            nextY += deltaY;
+            tileY += stepY;
+            normalY = -stepY;
+        }
+
+        if (distance > maxDistance) {
+            break;
+        }
+
+        // Once the ray has left the map there is nothing more it can hit
+        if ((tileX < 0 && stepX < 0) || (tileY < 0 && stepY < 0) || (tileX >= static_cast<int32_t>(_w) && stepX > 0) || (tileY >= static_cast<int32_t>(_h) && stepY > 0)) {
+            break;
+        }
+
+        if (solid(tileX, tileY)) {
+            result.hit = true;
+            result.tileX = tileX;
+            result.tileY = tileY;
+            result.x = originX + directionX * distance;
+            result.y = originY + directionY * distance;
+            result.normalX = normalX;
+            result.normalY = normalY;
+            result.distance = distance;
+            return result;
+        }
+    }
+
+    result.x = originX + directionX * maxDistance;
+    result.y = originY + directionY * maxDistance;
+    result.distance = maxDistance;
+    return result;
+}
+
+SL::Tilemap::RayHit SL::Tilemap::intersectSegment(double fromX, double fromY, double toX, double toY) {
+    double deltaX = toX - fromX;
+    double deltaY = toY - fromY;
+    return raycast(fromX, fromY, deltaX, deltaY, std::sqrt(deltaX * deltaX + deltaY * deltaY));
+}
+
+bool SL::Tilemap::lineOfSight(double fromX, double fromY, double toX, double toY) {
+    return !intersectSegment(fromX, fromY, toX, toY).hit;
+}
+
+void SL::Tilemap::update(long timeDelta) {
+    for (size_t i = 0; i < _layers.size(); i++) {
+        bool shared = false;
+        for (size_t j = 0; j < i && !shared; j++) {
+            shared = &_layers[j].tileset() == &_layers[i].tileset();
+        }
+        if (!shared) {
+            _layers[i].tileset().update(timeDelta);
+        }
+    }
+}
+
+void SL::Tilemap::focus(double x, double y) {
+    uint32_t tileX = static_cast<uint32_t>(std::max(x, 0.0) / 16);
+    uint32_t tileY = static_cast<uint32_t>(std::max(y, 0.0) / 16);
+    for (auto &layer : _layers) {
+        if (layer.streamer() != nullptr) {
+            layer.streamer()->focus(tileX, tileY);
+        }
+    }
+}
+
+void SL::Tilemap::waitForChunks() {
+    for (auto &layer : _layers) {
+        if (layer.streamer() != nullptr) {
+            layer.streamer()->wait();
+        }
+    }
+}
+
+uint32_t SL::Tilemap::reload(const SL::Tilemap &updated) {
+    uint32_t changedTiles = 0;
+
+    if (_layers.size() > updated._layers.size()) {
+        _layers.erase(_layers.begin() + updated._layers.size(), _layers.end());
+    }
+
+    for (size_t i = 0; i < updated._layers.size(); i++) {
+        if (i < _layers.size()) {
+            changedTiles += _layers[i].reload(updated._layers[i]);
+        } else {
+            _layers.push_back(updated._layers[i]);
+            changedTiles += updated._w * updated._h;
+        }
+    }
+
+    _w = updated._w;
+    _h = updated._h;
+    _playerSpawnX = updated._playerSpawnX;
+    _playerSpawnY = updated._playerSpawnY;
+    _cameraSpawnX = updated._cameraSpawnX;
+    _cameraSpawnY = updated._cameraSpawnY;
+    _bgImage = updated._bgImage;
+    _mgImage = updated._mgImage;
+    _objects = updated._objects;
+
+    _collisionLayer = updated._collisionLayer;
+    _tileShapes = updated._tileShapes;
+    buildCollision();
+
+    return changedTiles;
+}
+
+namespace {
+    template<typename T>
+    uint32_t reloadTiles(std::vector<T> &tiles, const std::vector<T> &updated) {
+        uint32_t changedTiles = 0;
+        for (size_t i = 0; i < tiles.size(); i++) {
+            if (tiles[i] != updated[i]) {
+                tiles[i] = updated[i];
+                changedTiles++;
+            }
+        }
+        return changedTiles;
+    }
+}
+
+SL::Tilemap::Layer::Layer(Gfx *gfx, Image tileset, uint32_t width, uint32_t height, const std::vector<uint32_t> &tiles, TileLayout layout)
+        : Layer(gfx, std::make_shared<Tileset>(std::move(tileset)), width, height, tiles, layout) {
+}
+
+SL::Tilemap::Layer::Layer(Gfx *gfx, std::shared_ptr<Tileset> tileset, uint32_t width, uint32_t height, const std::vector<uint32_t> &tiles, TileLayout layout) : _gfx{gfx},
+                                                                                                                        _tileset{std::move(tileset)}, _w{width}, _h{height},
+                                                                                                                        _layout{layout},
+                                                                                                                        _blocksWide{(width + BlockMask) >> BlockShift} {
+    // The tileset bounds the gids a layer will normally use, but a layer referring past it must not be truncated
+    uint32_t largestTile = _tileset->tileCount();
+    for (auto tile : tiles) {
+        largestTile = std::max(largestTile, tile);
+    }
+
+    if (largestTile <= UINT8_MAX) {
+        _bytesPerTile = 1;
+        storeTiles(_tiles8, tiles);
+    } else if (largestTile <= UINT16_MAX) {
+        _bytesPerTile = 2;
+        storeTiles(_tiles16, tiles);
+    } else {
+        _bytesPerTile = 4;
+        storeTiles(_tiles32, tiles);
+    }
+}
+
+SL::Tilemap::Layer::Layer(Gfx *gfx, std::shared_ptr<Tileset> tileset, uint32_t width, uint32_t height, std::shared_ptr<ChunkStreamer> streamer) : _gfx{gfx},
+                                                                                                                          _tileset{std::move(tileset)}, _w{width}, _h{height},
+                                                                                                                          _layout{TileLayout::RowMajor},
+                                                                                                                          _blocksWide{(width + BlockMask) >> BlockShift},
+                                                                                                                          _bytesPerTile{4},
+                                                                                                                          _streamer{std::move(streamer)} {
+}
+
+template<typename T>
+void SL::Tilemap::Layer::storeTiles(std::vector<T> &storage, const std::vector<uint32_t> &tiles) {
+    if (_layout == TileLayout::RowMajor) {
+        storage.assign(tiles.begin(), tiles.end());
+        return;
+    }
+
+    // Blocks along the right and bottom edges are padded with empty tiles
+    uint32_t blocksHigh = (_h + BlockMask) >> BlockShift;
+    storage.assign(_blocksWide * blocksHigh * BlockSize * BlockSize, 0);
+    for (uint32_t y = 0; y < _h; y++) {
+        for (uint32_t x = 0; x < _w; x++) {
+            storage[index(x, y)] = static_cast<T>(tiles[y * _w + x]);
+        }
+    }
+}
+
+int32_t SL::Tilemap::Layer::tile(uint32_t x, uint32_t y) const {
+    if (_streamer) {
+        return _streamer->tile(x, y);
+    } else if (_bytesPerTile == 1) {
+        return _tiles8[index(x, y)];
+    } else if (_bytesPerTile == 2) {
+        return _tiles16[index(x, y)];
+    }
+    return _tiles32[index(x, y)];
+}
+
+SL::Tileset &SL::Tilemap::Layer::tileset() {
+    return *_tileset;
+}
+
+SL::ChunkStreamer *SL::Tilemap::Layer::streamer() const {
+    return _streamer.get();
+}
+
+SL::Tilemap::TileLayout SL::Tilemap::Layer::layout() const {
+    return _layout;
+}
+
+uint32_t SL::Tilemap::Layer::bytesPerTile() {
+    return _bytesPerTile;
+}
+
+uint32_t SL::Tilemap::Layer::reload(const SL::Tilemap::Layer &updated) {
+    // Layers keep sharing their own tileset, which takes on the updated image and animations
+    std::shared_ptr<Tileset> tileset = _tileset;
+    if (tileset != updated._tileset) {
+        tileset->reload(*updated._tileset);
+    }
+
+    if (_w != updated._w || _h != updated._h || _streamer || updated._streamer) {
+        *this = updated;
+        _tileset = tileset;
+        return _w * _h;
+    }
+
+    if (_bytesPerTile != updated._bytesPerTile || _layout != updated._layout) {
+        uint32_t changedTiles = 0;
+        for (uint32_t y = 0; y < _h; y++) {
+            for (uint32_t x = 0; x < _w; x++) {
+                changedTiles += tile(x, y) != updated.tile(x, y);
+            }
+        }
+        *this = updated;
+        _tileset = tileset;
+        return changedTiles;
+    }
+
+    if (_bytesPerTile == 1) {
+        return reloadTiles(_tiles8, updated._tiles8);
+    } else if (_bytesPerTile == 2) {
+        return reloadTiles(_tiles16, updated._tiles16);
+    }
+    return reloadTiles(_tiles32, updated._tiles32);
+}
+
+void SL::Tilemap::Layer::draw(int32_t x, int32_t y) {
+    visit([this, x, y](uint32_t tx, uint32_t ty, int32_t tile) {
+        if (tile != 0) {
+            drawTile(static_cast<uint32_t>(tile), x + tx * 16, y + ty * 16);
+        }
+    });
+}
+
+void SL::Tilemap::Layer::draw(int32_t x, int32_t y, uint32_t viewWidth, uint32_t viewHeight) {
+    // Only the tiles overlapping the view, which starts at -x, -y in layer space, are drawn. The view can start
+    // above or left of the layer, so its far edge is floored rather than truncated towards tile zero.
+    int32_t left = std::max(-x, 0) / 16;
+    int32_t top = std::max(-y, 0) / 16;
+    int32_t right = tileAt(-x + static_cast<int32_t>(viewWidth) - 1);
+    int32_t bottom = tileAt(-y + static_cast<int32_t>(viewHeight) - 1);
+    if (right < 0 || bottom < 0) {
+        return;
+    }
+
+    visit(static_cast<uint32_t>(left), static_cast<uint32_t>(top), static_cast<uint32_t>(right), static_cast<uint32_t>(bottom),
+          [this, x, y](uint32_t tx, uint32_t ty, int32_t tile) {
+              if (tile != 0) {
+                  drawTile(static_cast<uint32_t>(tile), x + tx * 16, y + ty * 16);
+              }
+          });
+}
+
+void SL::Tilemap::Layer::drawTile(uint32_t tileNumber, int32_t x, int32_t y) {
+    Tileset::TileInfo tile = _tileset->info(tileNumber);
+    _gfx->drawImage(_tileset->image(), x, y, tile.sourceX, tile.sourceY, 16, 16, (tile.flags & Tileset::TileFlipped) != 0);
+}
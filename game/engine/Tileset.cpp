@@ -0,0 +1,94 @@
+#include "engine.h"
+
+SL::Tileset::Tileset(SL::Image image) : _image{std::move(image)} {
+    _columns = _image.width() / 16;
+    _tileCount = _columns * (_image.height() / 16);
+
+    _tiles.reserve(_tileCount + 1);
+    _tiles.push_back(TileInfo{0, 0, 0});
+    reserve(_tileCount);
+}
+
+SL::Image &SL::Tileset::image() {
+    return _image;
+}
+
+uint32_t SL::Tileset::tileCount() const {
+    return _tileCount;
+}
+
+SL::Tileset::TileInfo SL::Tileset::sourceRect(uint32_t gid, uint8_t flags) const {
+    if (gid == 0 || _columns == 0) {
+        return TileInfo{0, 0, flags};
+    }
+    return TileInfo{static_cast<uint16_t>((gid - 1) % _columns * 16), static_cast<uint16_t>((gid - 1) / _columns * 16), flags};
+}
+
+void SL::Tileset::reserve(uint32_t gid) {
+    while (_tiles.size() <= gid) {
+        _tiles.push_back(sourceRect(static_cast<uint32_t>(_tiles.size()), 0));
+    }
+}
+
+uint8_t SL::Tileset::flags(uint32_t gid) const {
+    return info(gid).flags;
+}
+
+void SL::Tileset::setFlags(uint32_t gid, uint8_t flags) {
+    reserve(gid);
+    _tiles[gid].flags = flags;
+}
+
+void SL::Tileset::addAnimation(uint32_t gid, std::vector<Frame> frames) {
+    if (frames.empty()) {
+        return;
+    }
+
+    uint32_t length = 0;
+    for (auto &frame : frames) {
+        length += frame.duration;
+    }
+
+    reserve(gid);
+    _tiles[gid].flags |= TileAnimated;
+    _animations.push_back(Animation{gid, length, std::move(frames)});
+    update(0);
+}
+
+uint32_t SL::Tileset::animationCount() const {
+    return static_cast<uint32_t>(_animations.size());
+}
+
+uint32_t SL::Tileset::frame(uint32_t gid) const {
+    if (gid >= _tiles.size() || (_tiles[gid].flags & TileAnimated) == 0 || _columns == 0) {
+        return gid;
+    }
+    return (_tiles[gid].sourceY / 16) * _columns + _tiles[gid].sourceX / 16 + 1;
+}
+
+void SL::Tileset::update(long timeDelta) {
+    _clock += timeDelta;
+
+    for (auto &animation : _animations) {
+        if (animation.length == 0) {
+            continue;
+        }
+
+        long time = _clock % animation.length;
+        for (auto &frame : animation.frames) {
+            if (time < static_cast<long>(frame.duration)) {
+                _tiles[animation.gid] = sourceRect(frame.gid, _tiles[animation.gid].flags);
+                break;
+            }
+            time -= frame.duration;
+        }
+    }
+}
+
+void SL::Tileset::reload(const SL::Tileset &updated) {
+    // The clock carries over so animations continue from where they were
+    long clock = _clock;
+    *this = updated;
+    _clock = 0;
+    update(clock);
+}
@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
 #include <utility>
 #include "engine.h"
 
@@ -6,17 +11,30 @@ SL::Engine::Engine(SL::Gfx *gfx, SL::Input *input, SL::Time *time, SL::Sleeper *
     _input->addQuitHandler([&] {
         _alive = false;
     });
-
-    _input->addKeyHandler([&](SL::KeyType key, SL::ActionType action) {
-        _activeScene->keyEvent(key, action);
-    });
 }
 
 bool SL::Engine::update() {
     _gfx->update();
     _input->update();
 
-    _activeScene->update(_time->currentTime() - _lastTime);
+    // The scene sees each key event once, in the tick the input polled it
+    _input->events().drain(_inputCursor, [&](const SL::InputEvent &event) {
+        if (_inputRecorder != nullptr) {
+            _inputRecorder->keyEvent(event.key, event.action);
+        }
+        _activeScene->keyEvent(event.key, event.action);
+    });
+
+    if (_fileWatcher != nullptr) {
+        _fileWatcher->update();
+    }
+
+    long delta = _time->currentTime() - _lastTime;
+    if (_inputRecorder != nullptr) {
+        _inputRecorder->frame(delta);
+    }
+
+    _activeScene->update(delta);
     _lastTime = _time->currentTime();
 
     _sleeper->sleep(_time->currentTime());
@@ -29,14 +47,364 @@ void SL::Engine::displayScene(SL::Scene *scene) {
 }
 
 SL::Sprite SL::Engine::createSprite(const std::string &filename, uint32_t cellWidth, uint32_t cellHeight) {
-    return {_gfx, _gfx->loadImage(filename), cellWidth, cellHeight};
+    return {_gfx, loadImage(filename), cellWidth, cellHeight};
+}
+
+std::shared_ptr<SL::AnimationClip> SL::Engine::createClip(const std::string &filename, uint32_t cellWidth, uint32_t cellHeight, std::vector<uint32_t> frameDurations,
+                                                          SL::AnimationClip::Loop loop, uint32_t count) {
+    return std::make_shared<SL::AnimationClip>(_gfx, loadImage(filename), cellWidth, cellHeight, std::move(frameDurations), loop, count);
+}
+
+std::shared_ptr<SL::AnimationClip> SL::Engine::createClip(const std::string &filename, std::vector<SL::Rect> frames, std::vector<uint32_t> frameDurations,
+                                                          SL::AnimationClip::Loop loop) {
+    return std::make_shared<SL::AnimationClip>(_gfx, loadImage(filename), std::move(frames), std::move(frameDurations), loop);
 }
 
 SL::Parallax SL::Engine::createParallax(const std::string &filename, float travelDampening) {
-    return {_gfx, _gfx->loadImage(filename), travelDampening};
+    return {_gfx, loadImage(filename), travelDampening};
+}
+
+SL::ParticleSystem SL::Engine::createParticles(const std::string &filename, uint32_t cellWidth, uint32_t cellHeight, uint32_t capacity) {
+    return {_gfx, loadImage(filename), cellWidth, cellHeight, capacity};
+}
+
+namespace {
+    std::vector<uint32_t> tileData(nlohmann::json &layer, nlohmann::json &source, uint32_t tileCount) {
+        if (layer.find("encoding") != layer.end() && layer["encoding"].get<std::string>() == "base64") {
+            std::string compression = layer.find("compression") != layer.end() ? layer["compression"].get<std::string>() : "";
+            return SL::decodeTileData(source["data"].get_ref<const std::string &>(), compression, tileCount);
+        }
+        return source["data"].get<std::vector<uint32_t>>();
+    }
+
+    // Properties are a plain object in maps saved by Tiled 1.0 and an array of name/value pairs from 1.2 onwards
+    nlohmann::json *propertyValue(nlohmann::json &properties, const std::string &name) {
+        if (properties.is_array()) {
+            for (auto &property : properties) {
+                if (property["name"].get<std::string>() == name) {
+                    return &property["value"];
+                }
+            }
+            return nullptr;
+        }
+
+        return properties.find(name) != properties.end() ? &properties[name] : nullptr;
+    }
+
+    nlohmann::json *property(nlohmann::json &owner, const std::string &name) {
+        if (owner.find("properties") == owner.end()) {
+            return nullptr;
+        }
+        return propertyValue(owner["properties"], name);
+    }
+
+    bool boolProperty(nlohmann::json &owner, const std::string &name) {
+        nlohmann::json *value = property(owner, name);
+        return value != nullptr && value->is_boolean() && value->get<bool>();
+    }
+
+    // Maps opt in to the blocked layout with a "tile_layout" property of "blocked", a layer may override its map
+    SL::Tilemap::TileLayout tileLayout(nlohmann::json &owner, SL::Tilemap::TileLayout fallback) {
+        nlohmann::json *value = property(owner, "tile_layout");
+        if (value == nullptr || !value->is_string()) {
+            return fallback;
+        }
+        if (value->get<std::string>() == "blocked") {
+            return SL::Tilemap::TileLayout::Blocked;
+        } else if (value->get<std::string>() == "row_major") {
+            return SL::Tilemap::TileLayout::RowMajor;
+        }
+        throw std::domain_error("Unknown tile layout " + value->get<std::string>());
+    }
+
+    // Height of a collision polygon's top edge at x, measured down from the top of the tile
+    double polygonSurface(nlohmann::json &object, double x) {
+        double objectX = object["x"].get<double>();
+        double objectY = object["y"].get<double>();
+        auto &points = object["polygon"];
+        double surface = 16.0;
+
+        for (size_t i = 0; i < points.size(); i++) {
+            auto &a = points[i];
+            auto &b = points[(i + 1) % points.size()];
+            double ax = objectX + a["x"].get<double>();
+            double ay = objectY + a["y"].get<double>();
+            double bx = objectX + b["x"].get<double>();
+            double by = objectY + b["y"].get<double>();
+
+            if (ax == bx) {
+                if (ax == x) {
+                    surface = std::min(surface, std::min(ay, by));
+                }
+            } else if (x >= std::min(ax, bx) && x <= std::max(ax, bx)) {
+                surface = std::min(surface, ay + (by - ay) * (x - ax) / (bx - ax));
+            }
+        }
+
+        return std::min(std::max(surface, 0.0), 16.0);
+    }
+
+    SL::TileShape tileShape(nlohmann::json *properties, nlohmann::json *objectGroup) {
+        SL::TileShape shape{SL::TileShape::Solid, 0, 0};
+
+        if (properties != nullptr) {
+            nlohmann::json *oneWay = propertyValue(*properties, "one_way");
+            if (oneWay != nullptr && oneWay->is_boolean() && oneWay->get<bool>()) {
+                shape.type = SL::TileShape::OneWay;
+                return shape;
+            }
+        }
+
+        if (objectGroup == nullptr) {
+            return shape;
+        }
+
+        double leftSurface = 16.0;
+        double rightSurface = 16.0;
+        for (auto &object : (*objectGroup)["objects"]) {
+            if (object.find("polygon") != object.end()) {
+                leftSurface = std::min(leftSurface, polygonSurface(object, 0.0));
+                rightSurface = std::min(rightSurface, polygonSurface(object, 16.0));
+            } else {
+                leftSurface = std::min(leftSurface, object["y"].get<double>());
+                rightSurface = std::min(rightSurface, object["y"].get<double>());
+            }
+        }
+
+        if (leftSurface > 0.0 || rightSurface > 0.0) {
+            shape.type = SL::TileShape::Slope;
+            shape.leftSurface = static_cast<uint8_t>(std::lround(leftSurface));
+            shape.rightSurface = static_cast<uint8_t>(std::lround(rightSurface));
+        }
+
+        return shape;
+    }
+
+    void setTileShape(std::vector<SL::TileShape> &shapes, uint32_t gid, SL::TileShape shape) {
+        if (gid >= shapes.size()) {
+            shapes.resize(gid + 1, SL::TileShape{SL::TileShape::Solid, 0, 0});
+        }
+        shapes[gid] = shape;
+    }
+
+    void setTileFlags(SL::Tileset &tileset, uint32_t gid, nlohmann::json *properties) {
+        uint8_t flags = tileset.flags(gid) & SL::Tileset::TileAnimated;
+        if (properties != nullptr) {
+            nlohmann::json *flipped = propertyValue(*properties, "flipped");
+            if (flipped != nullptr && flipped->is_boolean() && flipped->get<bool>()) {
+                flags |= SL::Tileset::TileFlipped;
+            }
+        }
+        tileset.setFlags(gid, flags);
+    }
+
+    void addTileAnimation(nlohmann::json &tile, uint32_t gid, uint32_t firstGid, SL::Tileset &tileset) {
+        if (tile.find("animation") == tile.end()) {
+            return;
+        }
+
+        std::vector<SL::Tileset::Frame> frames;
+        for (auto &frame : tile["animation"]) {
+            frames.push_back(SL::Tileset::Frame{firstGid + frame["tileid"].get<uint32_t>(), frame["duration"].get<uint32_t>()});
+        }
+        tileset.addAnimation(gid, std::move(frames));
+    }
+
+    void parseTile(nlohmann::json *tile, nlohmann::json *properties, uint32_t gid, uint32_t firstGid, std::vector<SL::TileShape> &shapes, SL::Tileset &tileset) {
+        nlohmann::json *objectGroup = tile != nullptr && tile->find("objectgroup") != tile->end() ? &(*tile)["objectgroup"] : nullptr;
+        SL::TileShape shape = tileShape(properties, objectGroup);
+        setTileShape(shapes, gid, shape);
+        setTileFlags(tileset, gid, properties);
+        if (tile != nullptr) {
+            addTileAnimation(*tile, gid, firstGid, tileset);
+        }
+    }
+
+    // Tiled 1.0 keys tiles and their properties by id in objects, later versions list tiles in an array
+    void parseTiles(nlohmann::json &tileset, uint32_t firstGid, std::vector<SL::TileShape> &shapes, SL::Tileset &tiles) {
+        if (tileset.find("tiles") != tileset.end() && tileset["tiles"].is_array()) {
+            for (auto &tile : tileset["tiles"]) {
+                nlohmann::json *properties = tile.find("properties") != tile.end() ? &tile["properties"] : nullptr;
+                parseTile(&tile, properties, firstGid + tile["id"].get<uint32_t>(), firstGid, shapes, tiles);
+            }
+            return;
+        }
+
+        nlohmann::json noTiles = nlohmann::json::object();
+        nlohmann::json &tileObjects = tileset.find("tiles") != tileset.end() ? tileset["tiles"] : noTiles;
+        nlohmann::json &tileProperties = tileset.find("tileproperties") != tileset.end() ? tileset["tileproperties"] : noTiles;
+
+        for (auto it = tileObjects.begin(); it != tileObjects.end(); ++it) {
+            nlohmann::json *properties = tileProperties.find(it.key()) != tileProperties.end() ? &tileProperties[it.key()] : nullptr;
+            parseTile(&it.value(), properties, firstGid + static_cast<uint32_t>(std::stoul(it.key())), firstGid, shapes, tiles);
+        }
+
+        for (auto it = tileProperties.begin(); it != tileProperties.end(); ++it) {
+            if (tileObjects.find(it.key()) == tileObjects.end()) {
+                parseTile(nullptr, &it.value(), firstGid + static_cast<uint32_t>(std::stoul(it.key())), firstGid, shapes, tiles);
+            }
+        }
+    }
+
+    int32_t intValue(nlohmann::json &owner, const std::string &name) {
+        return owner.find(name) != owner.end() ? static_cast<int32_t>(owner[name].get<double>()) : 0;
+    }
+
+    SL::MapObject mapObject(nlohmann::json &object, int32_t offsetX, int32_t offsetY) {
+        return SL::MapObject{
+                object.find("type") != object.end() ? object["type"].get<std::string>() : "",
+                object.find("name") != object.end() ? object["name"].get<std::string>() : "",
+                intValue(object, "x") - offsetX,
+                intValue(object, "y") - offsetY,
+                intValue(object, "width"),
+                intValue(object, "height"),
+                object.find("properties") != object.end() ? object["properties"] : nlohmann::json::object()
+        };
+    }
+
+    // Chunks have to lie within the map, which the infinite map's layers are normalised to
+    void checkChunkBounds(int32_t chunkX, int32_t chunkY, uint32_t chunkWidth, uint32_t chunkHeight, uint32_t width, uint32_t height) {
+        if (chunkX < 0 || chunkY < 0 || static_cast<uint64_t>(chunkX) + chunkWidth > width || static_cast<uint64_t>(chunkY) + chunkHeight > height) {
+            throw std::domain_error("Tile layer chunk lies outside the map");
+        }
+    }
+
+    void checkChunkData(const std::vector<uint32_t> &data, uint32_t chunkWidth, uint32_t chunkHeight) {
+        if (data.size() != static_cast<uint64_t>(chunkWidth) * chunkHeight) {
+            throw std::domain_error("Tile layer chunk data does not match chunk size");
+        }
+    }
+
+    std::vector<uint32_t> flattenChunks(nlohmann::json &layer, int32_t originX, int32_t originY, uint32_t width, uint32_t height) {
+        std::vector<uint32_t> tiles(width * height, 0);
+
+        for (auto &chunk : layer["chunks"]) {
+            int32_t chunkX = chunk["x"].get<int32_t>() - originX;
+            int32_t chunkY = chunk["y"].get<int32_t>() - originY;
+            uint32_t chunkWidth = chunk["width"].get<uint32_t>();
+            uint32_t chunkHeight = chunk["height"].get<uint32_t>();
+            checkChunkBounds(chunkX, chunkY, chunkWidth, chunkHeight, width, height);
+
+            const std::vector<uint32_t> &data = tileData(layer, chunk, chunkWidth * chunkHeight);
+            checkChunkData(data, chunkWidth, chunkHeight);
+
+            for (uint32_t i = 0; i < data.size(); i++) {
+                tiles[(chunkY + i / chunkWidth) * width + chunkX + i % chunkWidth] = data[i];
+            }
+        }
+
+        return tiles;
+    }
+
+    // Infinite maps with more tiles than this are streamed from their chunks rather than assembled into dense
+    // layers, so the decoded tiles held follow the view instead of the size of the level
+    const uint64_t StreamedMapTiles = 1u << 20;
+
+    // How far around the focus, in tiles, a streamed layer keeps chunks resident. Covers the game's view
+    // with room to spare so that chunks arrive before they scroll into sight
+    const uint32_t StreamedRadiusTiles = 32;
+
+    struct ChunkSource {
+        int32_t x;
+        int32_t y;
+        uint32_t width;
+        uint32_t height;
+        nlohmann::json data;
+    };
+
+    // A streamed layer keeps its chunks as they were encoded in the map and decodes them as the streamer
+    // asks for them. Only the streamer's background thread touches it once loading starts.
+    // The encoded chunks stay for the life of the map, so it is only the decoded tiles that are bounded,
+    // the rest grows with the map much as the file does
+    struct ChunkSources {
+        std::string encoding;
+        std::string compression;
+        uint32_t chunkSize;
+        std::vector<ChunkSource> chunks;
+
+        // Streamer chunk, keyed y << 32 | x, to the map chunks overlapping it
+        std::unordered_map<uint64_t, std::vector<size_t>> overlapping;
+    };
+
+    std::vector<uint32_t> decodeChunk(const ChunkSources &sources, const ChunkSource &chunk) {
+        std::vector<uint32_t> data = sources.encoding == "base64"
+                                     ? SL::decodeTileData(chunk.data.get_ref<const std::string &>(), sources.compression, chunk.width * chunk.height)
+                                     : chunk.data.get<std::vector<uint32_t>>();
+        checkChunkData(data, chunk.width, chunk.height);
+        return data;
+    }
+
+    std::vector<uint32_t> loadChunk(const ChunkSources &sources, uint32_t chunkX, uint32_t chunkY) {
+        uint32_t size = sources.chunkSize;
+        std::vector<uint32_t> tiles(size * size, 0);
+
+        auto overlapping = sources.overlapping.find((static_cast<uint64_t>(chunkY) << 32) | chunkX);
+        if (overlapping == sources.overlapping.end()) {
+            return tiles;
+        }
+
+        int32_t left = static_cast<int32_t>(chunkX * size);
+        int32_t top = static_cast<int32_t>(chunkY * size);
+        for (size_t index : overlapping->second) {
+            const ChunkSource &chunk = sources.chunks[index];
+            std::vector<uint32_t> data = decodeChunk(sources, chunk);
+
+            int32_t fromX = std::max(chunk.x, left);
+            int32_t toX = std::min(chunk.x + static_cast<int32_t>(chunk.width), left + static_cast<int32_t>(size));
+            int32_t fromY = std::max(chunk.y, top);
+            int32_t toY = std::min(chunk.y + static_cast<int32_t>(chunk.height), top + static_cast<int32_t>(size));
+            for (int32_t y = fromY; y < toY; y++) {
+                for (int32_t x = fromX; x < toX; x++) {
+                    tiles[(y - top) * size + (x - left)] = data[(y - chunk.y) * chunk.width + (x - chunk.x)];
+                }
+            }
+        }
+
+        return tiles;
+    }
+
+    std::shared_ptr<SL::ChunkStreamer> streamChunks(nlohmann::json &layer, int32_t originX, int32_t originY, uint32_t width, uint32_t height) {
+        auto sources = std::make_shared<ChunkSources>();
+        sources->encoding = layer.find("encoding") != layer.end() ? layer["encoding"].get<std::string>() : "";
+        sources->compression = layer.find("compression") != layer.end() ? layer["compression"].get<std::string>() : "";
+        sources->chunkSize = 0;
+
+        for (auto &chunk : layer["chunks"]) {
+            ChunkSource source{chunk["x"].get<int32_t>() - originX, chunk["y"].get<int32_t>() - originY, chunk["width"].get<uint32_t>(), chunk["height"].get<uint32_t>(),
+                               std::move(chunk["data"])};
+            checkChunkBounds(source.x, source.y, source.width, source.height, width, height);
+
+            // Streaming in the map's own chunk size means each streamed chunk decodes a single map chunk
+            if (sources->chunkSize == 0) {
+                sources->chunkSize = std::max(source.width, source.height);
+            }
+            sources->chunks.push_back(std::move(source));
+        }
+
+        uint32_t size = sources->chunkSize == 0 ? 16 : sources->chunkSize;
+        sources->chunkSize = size;
+        for (size_t i = 0; i < sources->chunks.size(); i++) {
+            const ChunkSource &chunk = sources->chunks[i];
+            if (chunk.width == 0 || chunk.height == 0) {
+                continue;
+            }
+            for (uint32_t chunkY = chunk.y / size; chunkY <= (chunk.y + chunk.height - 1) / size; chunkY++) {
+                for (uint32_t chunkX = chunk.x / size; chunkX <= (chunk.x + chunk.width - 1) / size; chunkX++) {
+                    sources->overlapping[(static_cast<uint64_t>(chunkY) << 32) | chunkX].push_back(i);
+                }
+            }
+        }
+
+        uint32_t radius = (StreamedRadiusTiles + size - 1) / size;
+        return std::make_shared<SL::ChunkStreamer>(width, height, size, radius, [sources](uint32_t chunkX, uint32_t chunkY) {
+            return loadChunk(*sources, chunkX, chunkY);
+        });
+    }
 }
 
-SL::Tilemap SL::Engine::createMap(const std::string mapData, const std::string tilesetImage) {
+SL::Tilemap SL::Engine::createMap(const std::string mapData, const std::string tilesetImage, const std::string &tilesetData) {
+    SL::StartupProfiler::Scope profile{_startupProfiler, "createMap", mapData.size()};
+
     auto mapJson = nlohmann::json::parse(mapData);
     auto layers = mapJson["layers"];
 
@@ -44,36 +412,144 @@ SL::Tilemap SL::Engine::createMap(const std::string mapData, const std::string t
     int32_t playerSpawnY = 0;
     int32_t cameraSpawnX = 0;
     int32_t cameraSpawnY = 0;
+    bool cameraSpawnFound = false;
+    std::vector<SL::MapObject> objects;
+
+    uint32_t width = mapJson["width"].get<uint32_t>();
+    uint32_t height = mapJson["height"].get<uint32_t>();
+
+    // Infinite maps store layers as chunks positioned relative to an arbitrary origin, the map is
+    // normalised so that the top left most chunk sits at tile 0,0.
+    bool infinite = mapJson.find("infinite") != mapJson.end() && mapJson["infinite"].get<bool>();
+    int32_t originX = 0;
+    int32_t originY = 0;
+
+    if (infinite) {
+        int32_t right = 0;
+        int32_t bottom = 0;
+        bool first = true;
+        for (auto &layer : layers) {
+            if (layer.find("chunks") != layer.end()) {
+                int32_t startX = layer["startx"].get<int32_t>();
+                int32_t startY = layer["starty"].get<int32_t>();
+                originX = first ? startX : std::min(originX, startX);
+                originY = first ? startY : std::min(originY, startY);
+                right = first ? startX + layer["width"].get<int32_t>() : std::max(right, startX + layer["width"].get<int32_t>());
+                bottom = first ? startY + layer["height"].get<int32_t>() : std::max(bottom, startY + layer["height"].get<int32_t>());
+                first = false;
+            }
+        }
+        width = static_cast<uint32_t>(right - originX);
+        height = static_cast<uint32_t>(bottom - originY);
+    }
+    bool streamed = infinite && static_cast<uint64_t>(width) * height > StreamedMapTiles;
+
+    int32_t tileWidth = mapJson.find("tilewidth") != mapJson.end() ? mapJson["tilewidth"].get<int32_t>() : 16;
+    int32_t tileHeight = mapJson.find("tileheight") != mapJson.end() ? mapJson["tileheight"].get<int32_t>() : 16;
 
     std::vector<SL::Tilemap::Layer> tilemapLayers;
-    SL::Image tileset = _gfx->loadImage(tilesetImage);
+    int32_t collisionLayer = -1;
+    std::shared_ptr<SL::Tileset> tileset = std::make_shared<SL::Tileset>(loadImage(tilesetImage));
+    SL::Tilemap::TileLayout mapLayout = tileLayout(mapJson, SL::Tilemap::TileLayout::RowMajor);
 
     for (auto &layer : layers) {
         if (layer.find("type") != layer.end() && layer["type"].get<std::string>() == "objectgroup") {
+            objects.reserve(objects.size() + layer["objects"].size());
             for (auto &object : layer["objects"]) {
-                if (object["type"].get<std::string>() == "player_spawn") {
-                    playerSpawnX = object["x"].get<int32_t>();
-                    playerSpawnY = object["y"].get<int32_t>();
-                } else {
-                    cameraSpawnX = object["x"].get<int32_t>();
-                    cameraSpawnY = object["y"].get<int32_t>();
+                objects.push_back(mapObject(object, originX * tileWidth, originY * tileHeight));
+                if (objects.back().type == "player_spawn") {
+                    playerSpawnX = objects.back().x;
+                    playerSpawnY = objects.back().y;
+                } else if (objects.back().type == "camera_spawn") {
+                    cameraSpawnX = objects.back().x;
+                    cameraSpawnY = objects.back().y;
+                    cameraSpawnFound = true;
                 }
             }
+            continue;
+        }
+
+        if (boolProperty(layer, "collision") || (collisionLayer < 0 && layer.find("name") != layer.end() && layer["name"].get<std::string>() == "Collision")) {
+            collisionLayer = static_cast<int32_t>(tilemapLayers.size());
+        }
+
+        if (layer.find("chunks") != layer.end() && streamed) {
+            tilemapLayers.emplace_back(_gfx, tileset, width, height, streamChunks(layer, originX, originY, width, height));
+        } else if (layer.find("chunks") != layer.end()) {
+            tilemapLayers.emplace_back(_gfx, tileset, width, height, flattenChunks(layer, originX, originY, width, height), tileLayout(layer, mapLayout));
         } else {
-            tilemapLayers.emplace_back(_gfx, tileset, layer["width"].get<uint32_t>(), layer["height"].get<uint32_t>(), layer["data"].get<std::vector<uint32_t>>());
+            uint32_t layerWidth = layer["width"].get<uint32_t>();
+            uint32_t layerHeight = layer["height"].get<uint32_t>();
+            tilemapLayers.emplace_back(_gfx, tileset, layerWidth, layerHeight, tileData(layer, layer, layerWidth * layerHeight), tileLayout(layer, mapLayout));
+        }
+    }
+
+    // Embedded tilesets carry their own tile definitions, external ones are supplied as exported JSON
+    std::vector<SL::TileShape> tileShapes;
+    bool tilesetParsed = false;
+    if (mapJson.find("tilesets") != mapJson.end()) {
+        for (auto &tilesetRef : mapJson["tilesets"]) {
+            uint32_t firstGid = tilesetRef.find("firstgid") != tilesetRef.end() ? tilesetRef["firstgid"].get<uint32_t>() : 1;
+            if (tilesetRef.find("tiles") != tilesetRef.end() || tilesetRef.find("tileproperties") != tilesetRef.end()) {
+                parseTiles(tilesetRef, firstGid, tileShapes, *tileset);
+            } else if (!tilesetData.empty() && !tilesetParsed) {
+                auto tilesetJson = nlohmann::json::parse(tilesetData);
+                parseTiles(tilesetJson, firstGid, tileShapes, *tileset);
+                tilesetParsed = true;
+            }
         }
     }
 
+    if (!tilesetData.empty() && !tilesetParsed) {
+        auto tilesetJson = nlohmann::json::parse(tilesetData);
+        parseTiles(tilesetJson, 1, tileShapes, *tileset);
+    }
+
+    // Without a camera spawn the camera starts on the player
+    if (!cameraSpawnFound) {
+        cameraSpawnX = playerSpawnX;
+        cameraSpawnY = playerSpawnY;
+    }
+
     std::string bgImageName = mapJson["properties"]["background"].get<std::string>();
     std::string mgImageName = mapJson["properties"]["middleground"].get<std::string>();
 
-    const uint32_t &width = mapJson["width"].get<uint32_t>();
-    const uint32_t &height = mapJson["height"].get<uint32_t>();
-    return SL::Tilemap(width, height, tilemapLayers, playerSpawnX, playerSpawnY, cameraSpawnX, cameraSpawnY, _gfx->loadImage(bgImageName),
-                       _gfx->loadImage(mgImageName));
+    return SL::Tilemap(width, height, tilemapLayers, collisionLayer, tileShapes, playerSpawnX, playerSpawnY, cameraSpawnX, cameraSpawnY, loadImage(bgImageName),
+                       loadImage(mgImageName), std::move(objects));
 }
 
 SL::Sprite SL::Engine::createSprite(const std::string &imageFilename) {
-    Image image = _gfx->loadImage(imageFilename);
+    Image image = loadImage(imageFilename);
     return SL::Sprite(_gfx, image, image.width(), image.height());
 }
+
+void SL::Engine::enableHotReload(SL::FileWatcher *fileWatcher) {
+    _fileWatcher = fileWatcher;
+}
+
+void SL::Engine::watchFile(const std::string &filename, std::function<void()> changeHandler) {
+    if (_fileWatcher != nullptr) {
+        _fileWatcher->watch(filename, std::move(changeHandler));
+    }
+}
+
+void SL::Engine::profileStartup(SL::StartupProfiler *profiler) {
+    _startupProfiler = profiler;
+}
+
+SL::StartupProfiler *SL::Engine::startupProfiler() {
+    return _startupProfiler;
+}
+
+void SL::Engine::recordInput(SL::InputRecorder *recorder) {
+    _inputRecorder = recorder;
+}
+
+SL::Image SL::Engine::loadImage(const std::string &filename) {
+    SL::StartupProfiler::Scope profile{_startupProfiler, "loadImage " + filename};
+
+    SL::Image image = _gfx->loadImage(filename);
+    profile.addBytes(static_cast<uint64_t>(image.width()) * image.height() * 4);
+
+    return image;
+}
@@ -1,7 +1,19 @@
 #pragma once
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <functional>
 #include <vector>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <exception>
 #include "json.hpp"
 
 namespace SL {
@@ -21,6 +33,8 @@ namespace SL {
 
     class Gfx;
 
+    std::vector<uint32_t> decodeTileData(const std::string &data, const std::string &compression, uint32_t tileCount);
+
     class Image {
     public:
         Image(const std::string &filename, uint32_t width, uint32_t height);
@@ -49,25 +63,133 @@ namespace SL {
         int32_t _y{0};
     };
 
+    struct Rect {
+        int32_t x;
+        int32_t y;
+        int32_t width;
+        int32_t height;
+
+        bool operator==(const Rect &other) const {
+            return x == other.x && y == other.y && width == other.width && height == other.height;
+        }
+    };
+
+    // Immutable frame data, shared by every sprite or entity playing the clip. Frame rectangles are worked
+    // out once, so drawing a frame is a single indexed fetch
+    class AnimationClip {
+    public:
+        enum class Loop : uint8_t {
+            Repeat,
+            Once
+        };
+
+        static const uint32_t DefaultFrameDuration = 83;
+
+        // Frames are the grid cells of the image, left to right then top to bottom. A count limits them to
+        // the first cells, for sheets whose last row is not full. Without durations every frame lasts
+        // DefaultFrameDuration milliseconds
+        AnimationClip(Gfx *gfx, Image image, uint32_t cellWidth, uint32_t cellHeight, std::vector<uint32_t> frameDurations = std::vector<uint32_t>(),
+                      Loop loop = Loop::Repeat, uint32_t count = UINT32_MAX);
+
+        AnimationClip(Gfx *gfx, Image image, std::vector<Rect> frames, std::vector<uint32_t> frameDurations = std::vector<uint32_t>(), Loop loop = Loop::Repeat);
+
+        uint32_t frameCount() const;
+        const Rect &frame(uint32_t frame) const;
+        uint32_t frameDuration(uint32_t frame) const;
+        // Every frame's duration added together
+        uint32_t duration() const;
+        Loop loop() const;
+
+        void draw(uint32_t frame, int32_t x, int32_t y, bool horizontallyFlipped);
+
+        bool operator==(const AnimationClip &other) const;
+        bool operator!=(const AnimationClip &other) const;
+
+    private:
+        Gfx *_gfx;
+        Image _image;
+        std::vector<Rect> _frames;
+        std::vector<uint32_t> _frameDurations;
+        uint32_t _duration;
+        Loop _loop;
+    };
+
+    // Per-instance playback state, small enough to keep one per entity in a flat array
+    struct AnimationPlayback {
+        AnimationClip *clip;
+        uint32_t elapsed;
+        uint16_t frame;
+        bool finished;
+
+        // Restarts from the first frame unless the clip is already playing
+        void play(AnimationClip *newClip);
+
+        void advance(long timeDelta);
+
+        void draw(int32_t x, int32_t y, bool horizontallyFlipped = false) const;
+
+        static void advanceAll(std::vector<AnimationPlayback> &playbacks, long timeDelta);
+    };
+
     class Sprite {
     public:
         Sprite(Gfx *gfx, Image image, uint32_t cellWidth, uint32_t cellHeight);
 
+        explicit Sprite(std::shared_ptr<AnimationClip> clip);
+
         uint32_t frameCount();
 
         void draw(int32_t x, int32_t y, bool horizontallyFlipped = false);
 
+        // Draws a given frame, for objects sharing the sprite that keep their own animation time
+        void drawFrame(uint32_t frame, int32_t x, int32_t y, bool horizontallyFlipped = false);
+
         void update(long timeDelta);
 
+        // Reloading changes the clip in place, so every sprite sharing it picks up the change
+        bool reload(const Sprite &updated);
+
+        const std::shared_ptr<AnimationClip> &clip() const;
+
     private:
-        Gfx *_gfx;
-        Image _image;
-        uint32_t _cellWidth;
-        uint32_t _cellHeight;
-        uint32_t _frames;
+        std::shared_ptr<AnimationClip> _clip;
+        AnimationPlayback _playback;
+    };
+
+    typedef uint16_t SpriteId;
+
+    // Sprites in one flat table, names are interned to ids when loading so that lookups while playing are
+    // plain indexing. Well-known names can be given fixed ids up front to match compile-time constants
+    class SpriteRegistry {
+    public:
+        SpriteId add(const std::string &name, Sprite sprite);
+
+        bool contains(const std::string &name) const;
+
+        // Throws for a name that was never added
+        SpriteId id(const std::string &name) const;
+
+        const std::string &name(SpriteId id) const;
+
+        Sprite &operator[](SpriteId id) {
+            return _sprites[id];
+        }
+
+        size_t size() const;
+
+    private:
+        std::vector<Sprite> _sprites;
+        std::vector<std::string> _names;
+        std::unordered_map<std::string, SpriteId> _ids;
+    };
 
-        uint32_t _lastTicks{0};
-        uint32_t _frame{0};
+    struct Quad {
+        int32_t x;
+        int32_t y;
+        int32_t sourceX;
+        int32_t sourceY;
+        int32_t width;
+        int32_t height;
     };
 
     class Gfx {
@@ -76,6 +198,9 @@ namespace SL {
         virtual Image loadImage(const std::string &basic_string) = 0;
         virtual void drawImage(Image &image, int32_t x, int32_t y, int32_t sourceX, int32_t sourceY, int32_t w, int32_t h, bool horizontallyFlipped) = 0;
         virtual void drawBackgroundLayer(Image &image, int32_t offsetX, int32_t offsetY) = 0;
+
+        // Draws every quad from the same image in a single submission
+        virtual void drawQuads(Image &image, const std::vector<Quad> &quads) = 0;
     };
 
     class Sleeper {
@@ -83,17 +208,74 @@ namespace SL {
         virtual void sleep(long currentTime) = 0;
     };
 
+    class Time {
+    public:
+        virtual long currentTime() = 0;
+    };
+
+    struct InputEvent {
+        KeyType key;
+        ActionType action;
+        uint64_t timestampMicros;
+    };
+
+    // Holds one tick's input events in storage allocated up front. Each subscriber keeps a cursor and drains
+    // the events it hasn't seen yet, so any number of them can read the same tick without copying it
+    class InputQueue {
+    public:
+        struct Cursor {
+            uint64_t tick;
+            size_t next;
+        };
+
+        explicit InputQueue(size_t capacity);
+
+        // Starts a new tick, dropping the previous tick's events
+        void clear();
+
+        // Returns false and drops the event when the tick already holds capacity events
+        bool push(InputEvent event);
+
+        // Raises the capacity, keeping the tick's events
+        void reserve(size_t capacity);
+
+        size_t size() const;
+
+        size_t capacity() const;
+
+        template<typename F>
+        void drain(Cursor &cursor, F f) const {
+            if (cursor.tick != _tick) {
+                cursor = Cursor{_tick, 0};
+            }
+
+            for (; cursor.next < _events.size(); cursor.next++) {
+                f(_events[cursor.next]);
+            }
+        }
+
+    private:
+        std::vector<InputEvent> _events;
+        size_t _capacity;
+        uint64_t _tick{1};
+    };
+
     class Input {
     public:
         virtual void update() = 0;
 
         virtual void addKeyHandler(std::function<void(KeyType, ActionType)> keyHandler) = 0;
         virtual void addQuitHandler(std::function<void()> quitHandler) = 0;
+
+        // The key events of the latest update, timestamped, for subscribers that drain them once per tick
+        virtual const InputQueue &events() const = 0;
     };
 
-    class Time {
+    class FileWatcher {
     public:
-        virtual long currentTime() = 0;
+        virtual void update() = 0;
+
+        virtual void watch(const std::string &filename, std::function<void()> changeHandler) = 0;
     };
 
     class Scene {
@@ -102,27 +284,361 @@ namespace SL {
         virtual void keyEvent(KeyType key, ActionType action) = 0;
     };
 
+    struct TileShape {
+        enum Type : uint8_t {
+            Solid,
+            OneWay,
+            Slope
+        };
+
+        Type type;
+
+        // Height of the walkable surface below the top of the tile at its left and right edges, in pixels
+        uint8_t leftSurface;
+        uint8_t rightSurface;
+    };
+
+    struct BodyBatch {
+        void add(double x, double y, double width, double height, double velocityX, double velocityY);
+
+        void clear();
+
+        size_t size();
+
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> width;
+        std::vector<double> height;
+        std::vector<double> velocityX;
+        std::vector<double> velocityY;
+        std::vector<uint8_t> contacts;
+    };
+
+    // Particles are kept as separate arrays so the update loops run over plain floats the compiler can
+    // vectorise. Dead particles are replaced by the last live one, so removal never shifts the arrays
+    class ParticleSystem {
+    public:
+        ParticleSystem(Gfx *gfx, Image image, uint32_t cellWidth, uint32_t cellHeight, uint32_t capacity);
+
+        // Velocities and gravity are in pixels per second, lifetime in milliseconds. Returns false when full,
+        // and for a lifetime that isn't positive, which a particle couldn't be animated over
+        bool emit(float x, float y, float velocityX, float velocityY, float lifetime);
+
+        void gravity(float pixelsPerSecondSquared);
+
+        void update(long timeDelta);
+
+        // Each particle plays the image's frames once over its lifetime
+        void draw(int32_t offsetX, int32_t offsetY);
+
+        uint32_t size() const;
+        uint32_t capacity() const;
+
+        float x(uint32_t particle) const;
+        float y(uint32_t particle) const;
+        uint16_t frame(uint32_t particle) const;
+
+    private:
+        Gfx *_gfx;
+        Image _image;
+        uint32_t _cellWidth;
+        uint32_t _cellHeight;
+        uint32_t _frames;
+        float _gravity{0.0f};
+        uint32_t _size{0};
+
+        std::vector<float> _x;
+        std::vector<float> _y;
+        std::vector<float> _velocityX;
+        std::vector<float> _velocityY;
+        std::vector<float> _age;
+        std::vector<float> _lifetime;
+        std::vector<uint16_t> _frame;
+        std::vector<Quad> _quads;
+    };
+
+    // Tile animations share the tileset's clock, update() rewrites the source rect of each animated gid once
+    // per tick so drawing an animated tile costs the same single table lookup as a static one
+    class Tileset {
+    public:
+        // Solidity isn't a tileset flag, a tile only collides on the map's collision layer, where its shape decides how
+        enum TileFlag : uint8_t {
+            TileAnimated = 1,
+            TileFlipped = 2
+        };
+
+        struct TileInfo {
+            uint16_t sourceX;
+            uint16_t sourceY;
+            uint8_t flags;
+        };
+
+        struct Frame {
+            uint32_t gid;
+            uint32_t duration;
+        };
+
+        explicit Tileset(Image image);
+
+        Image &image();
+        uint32_t tileCount() const;
+
+        TileInfo info(uint32_t gid) const {
+            return gid < _tiles.size() ? _tiles[gid] : sourceRect(gid, 0);
+        }
+
+        uint8_t flags(uint32_t gid) const;
+        void setFlags(uint32_t gid, uint8_t flags);
+
+        void addAnimation(uint32_t gid, std::vector<Frame> frames);
+        uint32_t animationCount() const;
+
+        // The gid currently drawn in place of gid
+        uint32_t frame(uint32_t gid) const;
+
+        void update(long timeDelta);
+
+        void reload(const Tileset &updated);
+
+    private:
+        struct Animation {
+            uint32_t gid;
+            uint32_t length;
+            std::vector<Frame> frames;
+        };
+
+        TileInfo sourceRect(uint32_t gid, uint8_t flags) const;
+        void reserve(uint32_t gid);
+
+        Image _image;
+        uint32_t _columns;
+        uint32_t _tileCount;
+        long _clock{0};
+        std::vector<Animation> _animations;
+
+        // Indexed by gid, covers at least every tile of the image
+        std::vector<TileInfo> _tiles;
+    };
+
+    // An object placed in the map editor, positioned in map pixels
+    struct MapObject {
+        std::string type;
+        std::string name;
+        int32_t x;
+        int32_t y;
+        int32_t width;
+        int32_t height;
+        nlohmann::json properties;
+    };
+
+    // Keeps the chunks around a focus tile resident, loading them on a background thread and evicting
+    // distant ones, so only a bounded part of a large map is ever decoded
+    class ChunkStreamer {
+    public:
+        typedef std::function<std::vector<uint32_t>(uint32_t chunkX, uint32_t chunkY)> ChunkLoader;
+
+        // Throws for an empty map or zero chunk size, there would be no chunk to focus on
+        ChunkStreamer(uint32_t width, uint32_t height, uint32_t chunkSize, uint32_t radius, ChunkLoader loader);
+
+        ~ChunkStreamer();
+
+        // A loader that throws has its exception rethrown here, on the thread streaming the map
+        void focus(uint32_t tileX, uint32_t tileY);
+
+        void wait();
+
+        // Tiles in chunks that aren't resident read as empty
+        int32_t tile(uint32_t x, uint32_t y);
+
+        bool resident(uint32_t chunkX, uint32_t chunkY);
+
+        size_t residentChunks();
+
+        size_t capacity();
+
+    private:
+        typedef uint64_t ChunkKey;
+
+        ChunkKey key(uint32_t chunkX, uint32_t chunkY);
+
+        bool inRange(ChunkKey key, uint32_t radius);
+
+        void integrateLoadedChunks();
+
+        void load();
+
+        uint32_t _w;
+        uint32_t _h;
+        uint32_t _chunkSize;
+        uint32_t _radius;
+        ChunkLoader _loader;
+
+        uint32_t _focusChunkX{0};
+        uint32_t _focusChunkY{0};
+
+        std::unordered_map<ChunkKey, std::vector<uint32_t>> _resident;
+        std::unordered_map<ChunkKey, bool> _requested;
+
+        std::mutex _mutex;
+        std::condition_variable _requestsAvailable;
+        std::condition_variable _requestsComplete;
+        std::deque<ChunkKey> _requests;
+        std::deque<std::pair<ChunkKey, std::vector<uint32_t>>> _loaded;
+        std::exception_ptr _error{};
+        bool _loading{false};
+        bool _alive{true};
+        std::thread _worker;
+    };
+
     class Tilemap {
     public:
+        // Row-major keeps each map row contiguous, blocked stores 8x8 tile blocks contiguously so that
+        // vertical scans and neighbourhood queries stay within a few cache lines on wide maps
+        enum class TileLayout : uint8_t {
+            RowMajor,
+            Blocked
+        };
+
         class Layer {
         public:
-            Layer(Gfx *gfx, Image tileset, uint32_t width, uint32_t height, std::vector<uint32_t> tiles);
-            int32_t tile(uint32_t x, uint32_t y);
+            Layer(Gfx *gfx, Image tileset, uint32_t width, uint32_t height, const std::vector<uint32_t> &tiles, TileLayout layout = TileLayout::RowMajor);
+            Layer(Gfx *gfx, std::shared_ptr<Tileset> tileset, uint32_t width, uint32_t height, const std::vector<uint32_t> &tiles, TileLayout layout = TileLayout::RowMajor);
+
+            // A streamed layer holds no tiles of its own, only the chunks its streamer has resident
+            Layer(Gfx *gfx, std::shared_ptr<Tileset> tileset, uint32_t width, uint32_t height, std::shared_ptr<ChunkStreamer> streamer);
+
+            int32_t tile(uint32_t x, uint32_t y) const;
+
+            Tileset &tileset();
+
+            // Null unless the layer is streamed
+            ChunkStreamer *streamer() const;
+
+            uint32_t bytesPerTile();
+            TileLayout layout() const;
 
             void draw(int32_t x, int32_t y);
+            void draw(int32_t x, int32_t y, uint32_t viewWidth, uint32_t viewHeight);
+
+            // Calls f(x, y, tile) for every tile of the layer, or of the inclusive region, in memory order
+            template<typename F>
+            void visit(F f) const {
+                visit(0, 0, _w - 1, _h - 1, f);
+            }
+
+            template<typename F>
+            void visit(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom, F f) const {
+                if (_w == 0 || _h == 0 || left >= _w || top >= _h) {
+                    return;
+                }
+                right = std::min(right, _w - 1);
+                bottom = std::min(bottom, _h - 1);
+                if (_streamer) {
+                    for (uint32_t y = top; y <= bottom; y++) {
+                        for (uint32_t x = left; x <= right; x++) {
+                            f(x, y, _streamer->tile(x, y));
+                        }
+                    }
+                } else if (_bytesPerTile == 1) {
+                    visitTiles(_tiles8, left, top, right, bottom, f);
+                } else if (_bytesPerTile == 2) {
+                    visitTiles(_tiles16, left, top, right, bottom, f);
+                } else {
+                    visitTiles(_tiles32, left, top, right, bottom, f);
+                }
+            }
+
+            uint32_t reload(const Layer &updated);
         private:
-            void drawTile(uint32_t tileX, uint32_t tileY, int32_t x, int32_t y);
+            static const uint32_t BlockShift = 3;
+            static const uint32_t BlockSize = 1 << BlockShift;
+            static const uint32_t BlockMask = BlockSize - 1;
+
+            uint32_t index(uint32_t x, uint32_t y) const {
+                if (_layout == TileLayout::RowMajor) {
+                    return y * _w + x;
+                }
+                return (((y >> BlockShift) * _blocksWide + (x >> BlockShift)) << (2 * BlockShift)) + ((y & BlockMask) << BlockShift) + (x & BlockMask);
+            }
+
+            template<typename T, typename F>
+            void visitTiles(const std::vector<T> &tiles, uint32_t left, uint32_t top, uint32_t right, uint32_t bottom, F &f) const {
+                if (_layout == TileLayout::RowMajor) {
+                    for (uint32_t y = top; y <= bottom; y++) {
+                        const T *tile = tiles.data() + y * _w + left;
+                        for (uint32_t x = left; x <= right; x++, tile++) {
+                            f(x, y, static_cast<int32_t>(*tile));
+                        }
+                    }
+                    return;
+                }
+
+                for (uint32_t blockY = top >> BlockShift; blockY <= bottom >> BlockShift; blockY++) {
+                    uint32_t fromY = std::max(top, blockY << BlockShift);
+                    uint32_t toY = std::min(bottom, (blockY << BlockShift) + BlockMask);
+                    for (uint32_t blockX = left >> BlockShift; blockX <= right >> BlockShift; blockX++) {
+                        uint32_t fromX = std::max(left, blockX << BlockShift);
+                        uint32_t toX = std::min(right, (blockX << BlockShift) + BlockMask);
+                        for (uint32_t y = fromY; y <= toY; y++) {
+                            const T *tile = tiles.data() + index(fromX, y);
+                            for (uint32_t x = fromX; x <= toX; x++, tile++) {
+                                f(x, y, static_cast<int32_t>(*tile));
+                            }
+                        }
+                    }
+                }
+            }
+
+            template<typename T>
+            void storeTiles(std::vector<T> &storage, const std::vector<uint32_t> &tiles);
+
+            void drawTile(uint32_t tileNumber, int32_t x, int32_t y);
             Gfx *_gfx;
-            Image _tileset;
+            std::shared_ptr<Tileset> _tileset;
             uint32_t _w;
             uint32_t _h;
-            std::vector<uint32_t> _tiles;
+            TileLayout _layout;
+            uint32_t _blocksWide;
+
+            // Only the narrowest vector able to hold every gid of the layer is populated
+            uint32_t _bytesPerTile;
+            std::vector<uint8_t> _tiles8;
+            std::vector<uint16_t> _tiles16;
+            std::vector<uint32_t> _tiles32;
+            std::shared_ptr<ChunkStreamer> _streamer;
+        };
+
+        enum Contact : uint8_t {
+            ContactLeft = 1,
+            ContactRight = 2,
+            ContactUp = 4,
+            ContactDown = 8
         };
 
-        Tilemap(uint32_t width, uint32_t height, std::vector<Layer> layers, int32_t playerSpawnX, int32_t playerSpawnY, int32_t cameraSpawnX, int32_t cameraSpawnY, Image bgImage, Image mgImage);
+        struct Sweep {
+            double x;
+            double y;
+            uint8_t contacts;
+        };
+
+        struct RayHit {
+            bool hit;
+            int32_t tileX;
+            int32_t tileY;
+            double x;
+            double y;
+            int32_t normalX;
+            int32_t normalY;
+            double distance;
+        };
+
+        Tilemap(uint32_t width, uint32_t height, std::vector<Layer> layers, int32_t collisionLayer, std::vector<TileShape> tileShapes, int32_t playerSpawnX, int32_t playerSpawnY, int32_t cameraSpawnX,
+                int32_t cameraSpawnY, Image bgImage, Image mgImage, std::vector<MapObject> objects = std::vector<MapObject>());
 
         Layer &layer(uint32_t index);
 
+        int32_t collisionLayer();
+
         int32_t playerSpawnX();
         int32_t playerSpawnY();
 
@@ -132,6 +648,8 @@ namespace SL {
         Image &bgImage();
         Image &mgImage();
 
+        const std::vector<MapObject> &objects() const;
+
         uint32_t width();
         uint32_t height();
 
@@ -143,11 +661,60 @@ namespace SL {
 
         bool checkCollisionUp(double x, double &y, double travelSpeed);
 
+        bool solid(int32_t tileX, int32_t tileY);
+
+        TileShape shape(int32_t tileX, int32_t tileY);
+
+        bool solidRow(int32_t tileY, int32_t fromTileX, int32_t toTileX);
+
+        bool solidColumn(int32_t tileX, int32_t fromTileY, int32_t toTileY);
+
+        Sweep sweep(double x, double y, double width, double height, double velocityX, double velocityY);
+
+        void sweep(BodyBatch &bodies, uint32_t threads = 1);
+
+        RayHit raycast(double originX, double originY, double directionX, double directionY, double maxDistance);
+
+        RayHit intersectSegment(double fromX, double fromY, double toX, double toY);
+
+        bool lineOfSight(double fromX, double fromY, double toX, double toY);
+
+        // Advances the animation clock of every tileset used by the layers
+        void update(long timeDelta);
+
+        // Moves the chunks streamed layers keep resident to surround a point in map pixels
+        void focus(double x, double y);
+
+        // Blocks until every chunk around the focus is resident, for the first frame of a level
+        void waitForChunks();
+
+        uint32_t reload(const Tilemap &updated);
+
     private:
+        void buildCollision();
+
+        void sweepRange(BodyBatch &bodies, size_t from, size_t to);
+
+        bool landOnShapes(int32_t row, int32_t left, int32_t right, double centerX, double previousBottom, double &bottom);
+
+        bool shaped(int32_t tileX, int32_t tileY);
+
+        bool stepUp(int32_t column, int32_t centerColumn, int32_t left, int32_t right, double height, Sweep &result, int32_t &top, int32_t &bottom);
+
         std::vector<Layer> _layers;
         uint32_t _w;
         uint32_t _h;
 
+        // One bit per tile of the collision layer, each row padded to a whole number of words. Full solid
+        // tiles are kept apart from one way platforms and slopes, which need their shape looking up. A streamed
+        // collision layer has no bits, its resident tiles are looked up instead.
+        int32_t _collisionLayer;
+        bool _streamedCollision{false};
+        std::vector<TileShape> _tileShapes;
+        uint32_t _collisionStride{0};
+        std::vector<uint64_t> _collision;
+        std::vector<uint64_t> _shapedCollision;
+
         int32_t _playerSpawnX;
         int32_t _playerSpawnY;
         int32_t _cameraSpawnX;
@@ -155,8 +722,512 @@ namespace SL {
 
         Image _bgImage;
         Image _mgImage;
+        std::vector<MapObject> _objects;
+    };
+
+    class SpatialGrid {
+    public:
+        explicit SpatialGrid(uint32_t tilesPerCell);
+
+        void insert(uint32_t id, double x, double y, double width, double height);
+
+        // Ignores ids that aren't in the grid
+        void move(uint32_t id, double x, double y, double width, double height);
+
+        void remove(uint32_t id);
+
+        void query(double x, double y, double width, double height, std::vector<uint32_t> &results);
+
+        size_t size();
+
+        size_t occupiedCells();
+
+    private:
+        struct Entry {
+            double x;
+            double y;
+            double width;
+            double height;
+            int32_t left;
+            int32_t top;
+            int32_t right;
+            int32_t bottom;
+            uint32_t queryStamp;
+            bool present;
+        };
+
+        uint64_t cellKey(int32_t cellX, int32_t cellY);
+
+        int32_t cellAt(double position);
+
+        void link(uint32_t id);
+
+        void unlink(uint32_t id);
+
+        double _cellSize;
+        size_t _size{0};
+        uint32_t _queryStamp{0};
+        std::vector<Entry> _entries;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> _cells;
+    };
+
+    // Decides which entities update each frame from where they are relative to the view. Entities near the
+    // view tick every frame, those in a wider ring tick every few frames, staggered by id, and everything
+    // further away sleeps untouched. Only the ring is queried, so the cost follows the nearby entity count
+    class ActivityScheduler {
+    public:
+        enum class Activity : uint8_t {
+            Asleep,
+            Reduced,
+            Active
+        };
+
+        struct Tick {
+            uint32_t id;
+            Activity activity;
+
+            // Frames since the entity last ticked, for catching up after a reduced rate tick or waking
+            uint32_t elapsedFrames;
+            bool woke;
+        };
+
+        ActivityScheduler(uint32_t tilesPerCell, double activeMargin, double reducedMargin, uint32_t reducedRate);
+
+        void insert(uint32_t id, double x, double y, double width, double height);
+
+        void move(uint32_t id, double x, double y, double width, double height);
+
+        void remove(uint32_t id);
+
+        // Fills ticks, ordered by id, with the entities due to update on this frame
+        void update(uint64_t frame, double viewX, double viewY, double viewWidth, double viewHeight, std::vector<Tick> &ticks);
+
+        Activity activity(uint32_t id) const;
+
+    private:
+        struct State {
+            double x;
+            double y;
+            double width;
+            double height;
+            uint64_t lastTick;
+            uint64_t lastSeen;
+            Activity activity;
+            bool seen;
+            bool present;
+        };
+
+        SpatialGrid _grid;
+        double _activeMargin;
+        double _reducedMargin;
+        uint32_t _reducedRate;
+        uint64_t _frame{0};
+        std::vector<State> _states;
+        std::vector<uint32_t> _nearby;
+    };
+
+    // Handles stay valid across other entities being created and destroyed, a destroyed entity's index is
+    // reused with a new generation so stale handles are rejected
+    struct Entity {
+        uint32_t index;
+        uint32_t generation;
+
+        bool operator==(const Entity &other) const {
+            return index == other.index && generation == other.generation;
+        }
+
+        bool operator!=(const Entity &other) const {
+            return !(*this == other);
+        }
+    };
+
+    class ComponentStorage {
+    public:
+        virtual ~ComponentStorage() = default;
+
+        virtual void remove(uint32_t entityIndex) = 0;
+
+        virtual size_t size() const = 0;
+
+        // Makes room for capacity components on entities with indices below entityIndices
+        virtual void reserve(size_t capacity, size_t entityIndices) = 0;
+    };
+
+    // Sparse set: components are packed in a dense array, with a sparse entity index to dense slot table
+    template<typename T>
+    class ComponentPool : public ComponentStorage {
+    public:
+        bool contains(uint32_t entityIndex) const {
+            return entityIndex < _sparse.size() && _sparse[entityIndex] != Absent;
+        }
+
+        T &add(uint32_t entityIndex, T component) {
+            if (entityIndex >= _sparse.size()) {
+                _sparse.resize(entityIndex + 1, Absent);
+            }
+            if (_sparse[entityIndex] != Absent) {
+                return _components[_sparse[entityIndex]] = std::move(component);
+            }
+            _sparse[entityIndex] = static_cast<uint32_t>(_components.size());
+            _entities.push_back(entityIndex);
+            _components.push_back(std::move(component));
+            return _components.back();
+        }
+
+        void remove(uint32_t entityIndex) override {
+            if (!contains(entityIndex)) {
+                return;
+            }
+            // The last component fills the gap so the dense arrays stay packed
+            uint32_t slot = _sparse[entityIndex];
+            _components[slot] = std::move(_components.back());
+            _entities[slot] = _entities.back();
+            _sparse[_entities[slot]] = slot;
+            _components.pop_back();
+            _entities.pop_back();
+            _sparse[entityIndex] = Absent;
+        }
+
+        void reserve(size_t capacity, size_t entityIndices) override {
+            _components.reserve(capacity);
+            _entities.reserve(capacity);
+            if (entityIndices > _sparse.size()) {
+                _sparse.resize(entityIndices, Absent);
+            }
+        }
+
+        T &get(uint32_t entityIndex) {
+            return _components[_sparse[entityIndex]];
+        }
+
+        size_t size() const override {
+            return _components.size();
+        }
+
+        uint32_t entityAt(size_t slot) const {
+            return _entities[slot];
+        }
+
+        T &at(size_t slot) {
+            return _components[slot];
+        }
+
+    private:
+        static const uint32_t Absent = UINT32_MAX;
+
+        std::vector<uint32_t> _sparse;
+        std::vector<uint32_t> _entities;
+        std::vector<T> _components;
+    };
+
+    template<typename T>
+    const uint32_t ComponentPool<T>::Absent;
+
+    class Registry {
+    public:
+        Entity create();
+
+        void destroy(Entity entity);
+
+        bool alive(Entity entity) const;
+
+        // The current handle for an index, for systems that track entities by index alone
+        Entity entity(uint32_t index) const;
+
+        size_t size() const;
+
+        // Entity indices handed out so far, alive or waiting to be reused
+        size_t indexCount() const;
+
+        void reserve(size_t entities);
+
+        template<typename T>
+        T &add(Entity entity, T component) {
+            if (!alive(entity)) {
+                throw std::domain_error("Component added to a destroyed entity");
+            }
+            return pool<T>().add(entity.index, std::move(component));
+        }
+
+        template<typename T>
+        void remove(Entity entity) {
+            if (alive(entity)) {
+                pool<T>().remove(entity.index);
+            }
+        }
+
+        template<typename T>
+        bool has(Entity entity) {
+            return alive(entity) && pool<T>().contains(entity.index);
+        }
+
+        // Only valid for an alive entity that has the component
+        template<typename T>
+        T &get(Entity entity) {
+            return pool<T>().get(entity.index);
+        }
+
+        template<typename T>
+        ComponentPool<T> &pool() {
+            uint32_t id = componentId<T>();
+            if (id >= _pools.size()) {
+                _pools.resize(id + 1);
+            }
+            if (!_pools[id]) {
+                _pools[id].reset(new ComponentPool<T>());
+            }
+            return *static_cast<ComponentPool<T> *>(_pools[id].get());
+        }
+
+        // Calls f(entity, first, others...) for every entity with all of the components, walking the dense
+        // array of the first component, so the rarest component should come first
+        template<typename First, typename... Others, typename F>
+        void each(F f) {
+            ComponentPool<First> &first = pool<First>();
+            for (size_t slot = 0; slot < first.size(); slot++) {
+                uint32_t index = first.entityAt(slot);
+                if (hasAll<Others...>(index)) {
+                    f(Entity{index, _generations[index]}, first.at(slot), pool<Others>().get(index)...);
+                }
+            }
+        }
+
+    private:
+        // The empty pack has its own overload so that it doesn't name an index it never reads
+        template<typename... Components>
+        typename std::enable_if<sizeof...(Components) == 0, bool>::type hasAll(uint32_t) {
+            return true;
+        }
+
+        template<typename First, typename... Others>
+        bool hasAll(uint32_t entityIndex) {
+            return pool<First>().contains(entityIndex) && hasAll<Others...>(entityIndex);
+        }
+
+        static uint32_t nextComponentId();
+
+        template<typename T>
+        static uint32_t componentId() {
+            static const uint32_t id = nextComponentId();
+            return id;
+        }
+
+        std::vector<uint32_t> _generations;
+        std::vector<uint32_t> _freeIndices;
+        std::vector<std::unique_ptr<ComponentStorage>> _pools;
+    };
+
+    // Maps Tiled object types to factories. Each type declares the components its factory adds, so a level
+    // load can grow every component pool once for all of its objects before creating any of them
+    class ObjectSpawner {
+    public:
+        typedef std::function<void(Registry &registry, Entity entity, const MapObject &object)> Factory;
+
+        explicit ObjectSpawner(Registry &registry);
+
+        template<typename... Components>
+        void define(const std::string &type, Factory factory) {
+            Kind kind{std::move(factory), std::vector<ComponentStorage *>{&_registry.pool<Components>()...}};
+            _kinds[type] = std::move(kind);
+        }
+
+        bool defines(const std::string &type) const;
+
+        // Returns the number of objects created, objects of undefined types are skipped
+        uint32_t spawn(const std::vector<MapObject> &objects);
+
+    private:
+        struct Kind {
+            Factory factory;
+            std::vector<ComponentStorage *> pools;
+        };
+
+        Registry &_registry;
+        std::unordered_map<std::string, Kind> _kinds;
+    };
+
+    // Fixed capacity pool for short-lived objects. All storage is allocated up front, freed slots are
+    // chained into a free list and their generation bumped so handles to a despawned object go stale
+    template<typename T>
+    class ObjectPool {
+    public:
+        typedef Entity Handle;
+
+        explicit ObjectPool(uint32_t capacity) : _objects(capacity), _generations(capacity, 0), _nextFree(capacity), _alive(capacity, 0) {
+            for (uint32_t i = 0; i < capacity; i++) {
+                _nextFree[i] = i + 1;
+            }
+        }
+
+        // Returns a handle that is never alive when the pool is full
+        Handle spawn(T object) {
+            if (_firstFree >= capacity()) {
+                return Handle{Invalid, 0};
+            }
+            uint32_t index = _firstFree;
+            _firstFree = _nextFree[index];
+            _objects[index] = std::move(object);
+            _alive[index] = 1;
+            _size++;
+            return Handle{index, _generations[index]};
+        }
+
+        void despawn(Handle handle) {
+            if (!alive(handle)) {
+                return;
+            }
+            _alive[handle.index] = 0;
+            _generations[handle.index]++;
+            _nextFree[handle.index] = _firstFree;
+            _firstFree = handle.index;
+            _size--;
+        }
+
+        bool alive(Handle handle) const {
+            return handle.index < capacity() && _alive[handle.index] && _generations[handle.index] == handle.generation;
+        }
+
+        // Null for a stale handle
+        T *get(Handle handle) {
+            return alive(handle) ? &_objects[handle.index] : nullptr;
+        }
+
+        // Calls f(handle, object) for every live object, f may despawn the object it is given
+        template<typename F>
+        void each(F f) {
+            for (uint32_t i = 0; i < capacity(); i++) {
+                if (_alive[i]) {
+                    f(Handle{i, _generations[i]}, _objects[i]);
+                }
+            }
+        }
+
+        uint32_t size() const {
+            return _size;
+        }
+
+        uint32_t capacity() const {
+            return static_cast<uint32_t>(_objects.size());
+        }
+
+        bool full() const {
+            return _size == capacity();
+        }
+
+    private:
+        static const uint32_t Invalid = UINT32_MAX;
+
+        std::vector<T> _objects;
+        std::vector<uint32_t> _generations;
+        std::vector<uint32_t> _nextFree;
+        std::vector<uint8_t> _alive;
+        uint32_t _firstFree{0};
+        uint32_t _size{0};
+    };
+
+    template<typename T>
+    const uint32_t ObjectPool<T>::Invalid;
+
+    class StartupProfiler {
+    public:
+        struct Entry {
+            std::string label;
+            uint64_t startMicros;
+            uint64_t durationMicros;
+            uint64_t bytes;
+        };
+
+        class Scope {
+        public:
+            Scope(StartupProfiler *profiler, std::string label, uint64_t bytes = 0);
+
+            ~Scope();
+
+            void addBytes(uint64_t bytes);
+
+        private:
+            StartupProfiler *_profiler;
+            std::string _label;
+            uint64_t _bytes;
+            uint64_t _startMicros;
+        };
+
+        StartupProfiler();
+
+        uint64_t elapsedMicros();
+
+        void record(const std::string &label, uint64_t startMicros, uint64_t durationMicros, uint64_t bytes);
+
+        std::vector<Entry> entries();
+
+        void report(std::ostream &out);
+
+        void reportJSON(std::ostream &out);
+
+    private:
+        std::chrono::steady_clock::time_point _start;
+        std::vector<Entry> _entries;
+    };
+
+    // Everything needed to play a session back exactly: how long each frame took and the keys pressed during it
+    struct InputRecording {
+        struct KeyEvent {
+            uint64_t frame;
+            KeyType key;
+            ActionType action;
+        };
+
+        std::vector<long> frameTimes;
+        std::vector<KeyEvent> keyEvents;
+
+        static InputRecording parse(const std::string &recordingJson);
+
+        void write(std::ostream &out) const;
+    };
+
+    class InputRecorder {
+    public:
+        void keyEvent(KeyType key, ActionType action);
+
+        // Ends the current frame, any key events after this belong to the next one
+        void frame(long delta);
+
+        const InputRecording &recording() const;
+
+    private:
+        InputRecording _recording;
     };
 
+    // Stands in for the input, clock and sleeper of a recorded session, replaying each frame with its recorded
+    // keys and delta without waiting in between. Quits once every recorded frame has played
+    class ReplayInput : public Input, public Time, public Sleeper {
+    public:
+        explicit ReplayInput(InputRecording recording);
+
+        void update() override;
+
+        void addKeyHandler(std::function<void(KeyType, ActionType)> keyHandler) override;
+
+        void addQuitHandler(std::function<void()> quitHandler) override;
+
+        // Recorded events are timestamped with the frame's recorded clock
+        const InputQueue &events() const override;
+
+        long currentTime() override;
+
+        void sleep(long currentTime) override;
+
+        bool finished() const;
+
+    private:
+        InputRecording _recording;
+        std::vector<std::function<void(KeyType, ActionType)>> _keyHandlers{};
+        std::function<void()> _quitHandler{};
+        InputQueue _events{64};
+        uint64_t _frame{0};
+        size_t _nextKeyEvent{0};
+        long _currentTime{0L};
+    };
 
     class Engine {
     public:
@@ -168,18 +1239,44 @@ namespace SL {
 
         Sprite createSprite(const std::string &filename, uint32_t cellWidth, uint32_t cellHeight);
 
+        std::shared_ptr<AnimationClip> createClip(const std::string &filename, uint32_t cellWidth, uint32_t cellHeight,
+                                                  std::vector<uint32_t> frameDurations = std::vector<uint32_t>(),
+                                                  AnimationClip::Loop loop = AnimationClip::Loop::Repeat, uint32_t count = UINT32_MAX);
+
+        std::shared_ptr<AnimationClip> createClip(const std::string &filename, std::vector<Rect> frames,
+                                                  std::vector<uint32_t> frameDurations = std::vector<uint32_t>(),
+                                                  AnimationClip::Loop loop = AnimationClip::Loop::Repeat);
+
         Parallax createParallax(const std::string &filename, float travelDampening);
 
-        Tilemap createMap(std::string mapData, std::string tilesetFile);
+        ParticleSystem createParticles(const std::string &filename, uint32_t cellWidth, uint32_t cellHeight, uint32_t capacity);
+
+        Tilemap createMap(std::string mapData, std::string tilesetFile, const std::string &tilesetData = "");
 
         Sprite createSprite(const std::string &imageFilename);
 
+        void enableHotReload(FileWatcher *fileWatcher);
+
+        void watchFile(const std::string &filename, std::function<void()> changeHandler);
+
+        void profileStartup(StartupProfiler *profiler);
+
+        StartupProfiler *startupProfiler();
+
+        void recordInput(InputRecorder *recorder);
+
     private:
+        Image loadImage(const std::string &filename);
+
         Gfx *_gfx{nullptr};
         Input *_input{nullptr};
+        InputQueue::Cursor _inputCursor{0, 0};
         Time *_time{nullptr};
         Sleeper *_sleeper{nullptr};
         Scene *_activeScene{nullptr};
+        FileWatcher *_fileWatcher{nullptr};
+        StartupProfiler *_startupProfiler{nullptr};
+        InputRecorder *_inputRecorder{nullptr};
 
 
         bool _alive{true};
@@ -190,7 +1287,8 @@ namespace SL {
     public:
         explicit JSONSpriteFactory(Engine &engine);
 
-        std::map<std::string, SL::Sprite> parse(const std::string &spritesJson);
+        // The well-known names, which the manifest must contain, take ids 0, 1, 2... in the order given
+        SpriteRegistry parse(const std::string &spritesJson, const std::vector<std::string> &wellKnownNames = std::vector<std::string>());
 
     private:
         Engine &_engine;
@@ -0,0 +1,13 @@
+#include "MockFileWatcher.h"
+
+void MockFileWatcher::update() {
+    updated = true;
+}
+
+void MockFileWatcher::watch(const std::string &filename, std::function<void()> changeHandler) {
+    _changeHandlers[filename] = changeHandler;
+}
+
+void MockFileWatcher::simulateChange(const std::string &filename) {
+    _changeHandlers.at(filename)();
+}
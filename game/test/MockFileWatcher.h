@@ -0,0 +1,22 @@
+#pragma once
+
+#include <engine.h>
+
+#include <map>
+
+class MockFileWatcher : public SL::FileWatcher {
+public:
+    MockFileWatcher() = default;
+
+    void update() override;
+
+    void watch(const std::string &filename, std::function<void()> changeHandler) override;
+
+    // Mock methods
+    void simulateChange(const std::string &filename);
+
+    bool updated{false};
+
+private:
+    std::map<std::string, std::function<void()>> _changeHandlers;
+};
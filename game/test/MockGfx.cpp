@@ -19,6 +19,12 @@ void MockGfx::drawBackgroundLayer(SL::Image &image, int32_t offsetX, int32_t off
     drawnLayer = image.filename()+","+std::to_string(offsetX)+","+std::to_string(offsetY);
 }
 
+void MockGfx::drawQuads(SL::Image &image, const std::vector<SL::Quad> &quads) {
+    drawnQuadsImage = image.filename();
+    drawnQuads = quads;
+    quadBatches++;
+}
+
 void MockGfx::simulateAvailableImage(const std::string &filename, uint32_t width, uint32_t height) {
     _availableImages.insert({filename, SL::Image{filename, width, height}});
 }
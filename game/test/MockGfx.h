@@ -16,11 +16,16 @@ public:
 
     void drawBackgroundLayer(SL::Image &image, int32_t offsetX, int32_t offsetY) override;
 
+    void drawQuads(SL::Image &image, const std::vector<SL::Quad> &quads) override;
+
     // Mocked methods
     void simulateAvailableImage(const std::string &filename, uint32_t width, uint32_t height);
 
     std::string drawnImage{""};
     std::string drawnLayer{""};
+    std::string drawnQuadsImage{""};
+    std::vector<SL::Quad> drawnQuads{};
+    uint32_t quadBatches{0};
 
     bool updated{false};
 
@@ -2,10 +2,21 @@
 
 void MockInput::update() {
     updated = true;
+
+    _events.clear();
+    _events.reserve(_pending.size());
+    for (auto &event : _pending) {
+        _events.push(event);
+    }
+    _pending.clear();
 }
 
 void MockInput::addKeyHandler(std::function<void(SL::KeyType, SL::ActionType)> keyHandler) {
-    _keyHandler = keyHandler;
+    _keyHandlers.push_back(keyHandler);
+}
+
+const SL::InputQueue &MockInput::events() const {
+    return _events;
 }
 
 void MockInput::addQuitHandler(std::function<void()> quitHandler) {
@@ -17,41 +28,48 @@ void MockInput::simulateQuit() {
 }
 
 void MockInput::simulateLeftPress() {
-    _keyHandler(SL::KeyType::Left, SL::ActionType::Press);
+    simulateKey(SL::KeyType::Left, SL::ActionType::Press);
 }
 
 void MockInput::simulateLeftRelease() {
-    _keyHandler(SL::KeyType::Left, SL::ActionType::Release);
+    simulateKey(SL::KeyType::Left, SL::ActionType::Release);
 }
 
 void MockInput::simulateRightPress() {
-    _keyHandler(SL::KeyType::Right, SL::ActionType::Press);
+    simulateKey(SL::KeyType::Right, SL::ActionType::Press);
 }
 
 void MockInput::simulateRightRelease() {
-    _keyHandler(SL::KeyType::Right, SL::ActionType::Release);
+    simulateKey(SL::KeyType::Right, SL::ActionType::Release);
 }
 
 void MockInput::simulateUpPress() {
-    _keyHandler(SL::KeyType::Up, SL::ActionType::Press);
+    simulateKey(SL::KeyType::Up, SL::ActionType::Press);
 }
 
 void MockInput::simulateUpRelease() {
-    _keyHandler(SL::KeyType::Up, SL::ActionType::Release);
+    simulateKey(SL::KeyType::Up, SL::ActionType::Release);
 }
 
 void MockInput::simulateDownPress() {
-    _keyHandler(SL::KeyType::Down, SL::ActionType::Press);
+    simulateKey(SL::KeyType::Down, SL::ActionType::Press);
 }
 
 void MockInput::simulateDownRelease() {
-    _keyHandler(SL::KeyType::Down, SL::ActionType::Release);
+    simulateKey(SL::KeyType::Down, SL::ActionType::Release);
 }
 
 void MockInput::simulateJumpPress() {
-    _keyHandler(SL::KeyType::Jump, SL::ActionType::Press);
+    simulateKey(SL::KeyType::Jump, SL::ActionType::Press);
 }
 
 void MockInput::simulateJumpRelease() {
-    _keyHandler(SL::KeyType::Jump, SL::ActionType::Release);
+    simulateKey(SL::KeyType::Jump, SL::ActionType::Release);
+}
+
+void MockInput::simulateKey(SL::KeyType key, SL::ActionType action) {
+    _pending.push_back(SL::InputEvent{key, action, timestampMicros});
+    for (auto &keyHandler : _keyHandlers) {
+        keyHandler(key, action);
+    }
 }
@@ -12,6 +12,9 @@ public:
 
     void addQuitHandler(std::function<void()> quitHandler) override;
 
+    // Events simulated since the last update, queued by that update as if it had polled them
+    const SL::InputQueue &events() const override;
+
     // Mock methods
     void simulateQuit();
 
@@ -36,9 +39,16 @@ public:
     void simulateJumpRelease();
 
     bool updated{false};
+    uint64_t timestampMicros{0};
 
     std::function<void()> _quitHandler{};
-    std::function<void(SL::KeyType, SL::ActionType)> _keyHandler{};
+    std::vector<std::function<void(SL::KeyType, SL::ActionType)>> _keyHandlers{};
+
+private:
+    void simulateKey(SL::KeyType key, SL::ActionType action);
+
+    SL::InputQueue _events{64};
+    std::vector<SL::InputEvent> _pending{};
 };
 
 
@@ -2,6 +2,8 @@
 
 void MockScene::update(long delta) {
     updatedTimeDelta = delta;
+    elapsedTime += delta;
+    updates++;
 }
 
 void MockScene::keyEvent(SL::KeyType key, SL::ActionType action) {
@@ -12,6 +12,8 @@ public:
 
     std::string keyStream{""};
     long updatedTimeDelta{0};
+    long elapsedTime{0};
+    int32_t updates{0};
 };
 
 
@@ -1,10 +1,21 @@
 #include <engine.h>
 #include <json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <sstream>
 #include "MockSleeper.h"
 #include "MockGfx.h"
 #include "MockInput.h"
 #include "MockTime.h"
 #include "MockScene.h"
+#include "MockFileWatcher.h"
+
+// Map fixtures are read from the source tree, the build points this at it
+#ifndef SL_TEST_MAPS
+#define SL_TEST_MAPS "test/maps/"
+#endif
 
 TEST_CASE("[Engine]") {
     MockGfx mockGfx;
@@ -12,6 +23,7 @@ TEST_CASE("[Engine]") {
     MockTime mockTime;
     MockScene mockScene;
     MockSleeper mockSleeper;
+    MockFileWatcher mockFileWatcher;
 
     mockGfx.simulateAvailableImage("test.xyz", 128, 32);
     mockGfx.simulateAvailableImage("layer.xyz", 200, 200);
@@ -103,6 +115,16 @@ TEST_CASE("[Engine]") {
         REQUIRE(mockGfx.drawnImage == "test.xyz,10,20,0,0,32,32,1");
     }
 
+    SECTION("Sprites can draw a given frame") {
+        SL::Sprite sprite = engine.createSprite("test.xyz", 32, 32);
+
+        sprite.drawFrame(2, 10, 20);
+        REQUIRE(mockGfx.drawnImage == "test.xyz,10,20,64,0,32,32,0");
+
+        sprite.drawFrame(5, 10, 20, true);
+        REQUIRE(mockGfx.drawnImage == "test.xyz,10,20,32,0,32,32,1");
+    }
+
     SECTION("Sprites update their frames render") {
 
         SL::Sprite sprite = engine.createSprite("test.xyz", 32, 32);
@@ -144,9 +166,63 @@ TEST_CASE("[Engine]") {
         mockInput.simulateJumpPress();
         mockInput.simulateJumpRelease();
 
+        engine.update();
+
         REQUIRE(mockScene.keyStream == "LdLuRdRuUdUuDdDuJdJu");
     }
 
+    SECTION("Every key handler and queue subscriber sees each event") {
+        std::string first;
+        std::string second;
+        auto handler = [](std::string &seen) {
+            return [&seen](SL::KeyType key, SL::ActionType action) {
+                seen += key == SL::KeyType::Left ? "L" : "?";
+                seen += action == SL::ActionType::Press ? "d" : "u";
+            };
+        };
+        mockInput.addKeyHandler(handler(first));
+        mockInput.addKeyHandler(handler(second));
+
+        mockInput.timestampMicros = 1500;
+        mockInput.simulateLeftPress();
+        mockInput.timestampMicros = 2500;
+        mockInput.simulateLeftRelease();
+        engine.update();
+
+        REQUIRE(mockScene.keyStream == "LdLu");
+        REQUIRE(first == "LdLu");
+        REQUIRE(second == "LdLu");
+
+        // The engine drained the tick's events for its scene, another subscriber still reads all of them
+        std::vector<uint64_t> timestamps;
+        SL::InputQueue::Cursor cursor{0, 0};
+        mockInput.events().drain(cursor, [&](const SL::InputEvent &event) {
+            timestamps.push_back(event.timestampMicros);
+        });
+
+        REQUIRE(timestamps.size() == 2);
+        REQUIRE(timestamps[0] == 1500);
+        REQUIRE(timestamps[1] == 2500);
+
+        SL::InputRecording recording;
+        recording.frameTimes.push_back(16);
+        recording.keyEvents.push_back(SL::InputRecording::KeyEvent{0, SL::KeyType::Left, SL::ActionType::Release});
+
+        SL::ReplayInput replay{recording};
+        MockScene replayScene;
+        SL::Engine replayEngine{&mockGfx, &replay, &replay, &replay};
+        replayEngine.displayScene(&replayScene);
+        replay.addKeyHandler(handler(first));
+        replay.addKeyHandler(handler(second));
+
+        replayEngine.update();
+
+        REQUIRE(replayScene.keyStream == "Lu");
+        REQUIRE(first == "LdLuLu");
+        REQUIRE(second == "LdLuLu");
+        REQUIRE(replay.events().size() == 1);
+    }
+
     SECTION("Parallax can be drawn") {
         SL::Parallax layer = engine.createParallax("layer.xyz", 1.0f);
 
@@ -372,6 +448,58 @@ TEST_CASE("[Engine]") {
         REQUIRE(gameMap.cameraSpawnY() == 345);
     }
 
+    SECTION("Map objects are kept and only camera_spawn moves the camera") {
+        const std::string tilemap =
+                R"({
+   "width":1,
+   "height":1,
+   "layers":[
+      {
+          "name":"Background",
+          "width":1,
+          "height":1,
+          "data":[0]
+      },
+      {
+          "type":"objectgroup",
+          "objects":[
+               {
+                   "type":"player_spawn",
+                   "x":10,
+                   "y":20
+               },
+               {
+                   "type":"slug",
+                   "name":"guard",
+                   "x":64.5,
+                   "y":32,
+                   "width":32,
+                   "height":21,
+                   "properties":{"speed":2}
+               }
+           ]
+       }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(gameMap.cameraSpawnX() == 10);
+        REQUIRE(gameMap.cameraSpawnY() == 20);
+        REQUIRE(gameMap.objects().size() == 2);
+        REQUIRE(gameMap.objects()[1].type == "slug");
+        REQUIRE(gameMap.objects()[1].name == "guard");
+        REQUIRE(gameMap.objects()[1].x == 64);
+        REQUIRE(gameMap.objects()[1].y == 32);
+        REQUIRE(gameMap.objects()[1].width == 32);
+        REQUIRE(gameMap.objects()[1].height == 21);
+        REQUIRE(gameMap.objects()[1].properties["speed"].get<int>() == 2);
+    }
+
     SECTION("Parallax backgrounds can be processed") {
         const std::string tilemap =
                 R"({
@@ -443,11 +571,151 @@ TEST_CASE("[Engine]") {
 
         SL::JSONSpriteFactory jsonSpriteFactory{engine};
 
-        std::map<std::string, SL::Sprite> spriteMap = jsonSpriteFactory.parse(sprites);
+        SL::SpriteRegistry spriteRegistry = jsonSpriteFactory.parse(sprites);
+
+        REQUIRE(spriteRegistry.size() == 3);
+        REQUIRE(spriteRegistry[spriteRegistry.id("idle")].frameCount() == 1);
+        REQUIRE(spriteRegistry[spriteRegistry.id("walk")].frameCount() == 2);
+        REQUIRE(spriteRegistry[spriteRegistry.id("jump")].frameCount() == 3);
+        REQUIRE_THROWS_AS(spriteRegistry.id("run"), const std::domain_error &);
+
+        // Well-known names take their ids in the order given, whatever the manifest order
+        enum WellKnown : SL::SpriteId {
+            Jump,
+            Idle
+        };
+        SL::SpriteRegistry wellKnown = jsonSpriteFactory.parse(sprites, {"jump", "idle"});
+
+        REQUIRE(wellKnown[Jump].frameCount() == 3);
+        REQUIRE(wellKnown[Idle].frameCount() == 1);
+        REQUIRE(wellKnown.id("walk") == 2);
+        REQUIRE(wellKnown.name(Jump) == "jump");
+        REQUIRE_THROWS_AS(jsonSpriteFactory.parse(sprites, {"idle", "run"}), const std::domain_error &);
+    }
+
+    SECTION("Sprite manifests can set frame durations and play once") {
+        const std::string sprites = R"({
+    "sprites":[
+        {
+            "name":"hurt",
+            "cw":32,
+            "ch":32,
+            "img":"hurt.xyz",
+            "durations":[50, 200],
+            "loop":false
+        }
+    ]
+})";
+        mockGfx.simulateAvailableImage("hurt.xyz", 96, 32);
+
+        SL::Sprite hurt = SL::JSONSpriteFactory{engine}.parse(sprites)[0];
+
+        REQUIRE(hurt.clip()->frameDuration(0) == 50);
+        REQUIRE(hurt.clip()->frameDuration(2) == 200);
+        REQUIRE(hurt.clip()->loop() == SL::AnimationClip::Loop::Once);
+
+        hurt.update(250);
+        hurt.draw(0, 0);
+        REQUIRE(mockGfx.drawnImage == "hurt.xyz,0,0,64,0,32,32,0");
+
+        hurt.update(1000);
+        hurt.draw(0, 0);
+        REQUIRE(mockGfx.drawnImage == "hurt.xyz,0,0,64,0,32,32,0");
+    }
+
+    SECTION("Sprite sheets can span several rows or list irregular frames") {
+        const std::string sprites = R"({
+    "sprites":[
+        {
+            "name":"grid",
+            "cw":32,
+            "ch":32,
+            "count":3,
+            "img":"sheet.xyz"
+        },
+        {
+            "name":"irregular",
+            "img":"sheet.xyz",
+            "frames":[
+                {"x":0, "y":0, "w":20, "h":30},
+                {"x":20, "y":5, "w":40, "h":25, "duration":40}
+            ]
+        }
+    ]
+})";
+        mockGfx.simulateAvailableImage("sheet.xyz", 64, 64);
+
+        SL::SpriteRegistry sheet = SL::JSONSpriteFactory{engine}.parse(sprites, {"grid", "irregular"});
+        SL::Sprite &grid = sheet[0];
+        SL::Sprite &irregular = sheet[1];
+
+        REQUIRE(grid.frameCount() == 3);
+        grid.drawFrame(1, 0, 0);
+        REQUIRE(mockGfx.drawnImage == "sheet.xyz,0,0,32,0,32,32,0");
+        grid.drawFrame(2, 0, 0);
+        REQUIRE(mockGfx.drawnImage == "sheet.xyz,0,0,0,32,32,32,0");
+
+        grid.update(83 * 3);
+        grid.draw(0, 0);
+        REQUIRE(mockGfx.drawnImage == "sheet.xyz,0,0,0,0,32,32,0");
+
+        REQUIRE(irregular.frameCount() == 2);
+        REQUIRE(irregular.clip()->frame(1).width == 40);
+        REQUIRE(irregular.clip()->frameDuration(0) == SL::AnimationClip::DefaultFrameDuration);
+        REQUIRE(irregular.clip()->frameDuration(1) == 40);
+        irregular.update(83);
+        irregular.draw(7, 8);
+        REQUIRE(mockGfx.drawnImage == "sheet.xyz,7,8,20,5,40,25,0");
+
+        SL::Sprite whole = engine.createSprite("sheet.xyz", 32, 32);
+        REQUIRE(whole.frameCount() == 4);
+        whole.drawFrame(3, 0, 0);
+        REQUIRE(mockGfx.drawnImage == "sheet.xyz,0,0,32,32,32,32,0");
+    }
 
-        REQUIRE(spriteMap.at("idle").frameCount() == 1);
-        REQUIRE(spriteMap.at("walk").frameCount() == 2);
-        REQUIRE(spriteMap.at("jump").frameCount() == 3);
+    SECTION("Animation playback states share clips and advance in one pass") {
+        std::shared_ptr<SL::AnimationClip> walk = engine.createClip("test.xyz", 32, 32, {100, 50});
+        std::shared_ptr<SL::AnimationClip> idle = engine.createClip("test.xyz", 64, 32);
+
+        REQUIRE(walk->frameCount() == 4);
+        REQUIRE(walk->frameDuration(3) == 50);
+        REQUIRE(idle->frameDuration(1) == SL::AnimationClip::DefaultFrameDuration);
+        REQUIRE(sizeof(SL::AnimationPlayback) <= 16);
+
+        std::vector<SL::AnimationPlayback> playbacks(3, SL::AnimationPlayback{walk.get(), 0, 0, false});
+        playbacks[1].elapsed = 60;
+        playbacks[2].play(idle.get());
+
+        SL::AnimationPlayback::advanceAll(playbacks, 120);
+        REQUIRE(playbacks[0].frame == 1);
+        REQUIRE(playbacks[0].elapsed == 20);
+        REQUIRE(playbacks[1].frame == 2);
+        REQUIRE(playbacks[2].frame == 1);
+
+        // Playing the running clip again keeps its position, a different clip restarts
+        playbacks[0].play(walk.get());
+        REQUIRE(playbacks[0].frame == 1);
+        playbacks[0].play(idle.get());
+        REQUIRE(playbacks[0].frame == 0);
+
+        SL::AnimationPlayback::advanceAll(playbacks, 80);
+        REQUIRE(playbacks[1].frame == 0);
+
+        playbacks[1].draw(5, 6, true);
+        REQUIRE(mockGfx.drawnImage == "test.xyz,5,6,0,0,32,32,1");
+
+        // A long pause skips whole passes through a looping clip, and ends a clip that plays once
+        REQUIRE(walk->duration() == 250);
+        SL::AnimationPlayback paused{walk.get(), 0, 0, false};
+        paused.advance(250L * 4000000 + 120);
+        REQUIRE(paused.frame == 1);
+        REQUIRE(paused.elapsed == 20);
+
+        std::shared_ptr<SL::AnimationClip> once = engine.createClip("test.xyz", 32, 32, {100, 50}, SL::AnimationClip::Loop::Once);
+        SL::AnimationPlayback pausedOnce{once.get(), 0, 0, false};
+        pausedOnce.advance(250L * 4000000 + 120);
+        REQUIRE(pausedOnce.frame == 3);
+        REQUIRE(pausedOnce.finished);
     }
 
 
@@ -806,4 +1074,1688 @@ TEST_CASE("[Engine]") {
         REQUIRE(y == 64.0);
         REQUIRE(collides);
     }
+
+    SECTION("File watcher is not polled unless hot reload is enabled") {
+        engine.update();
+
+        REQUIRE(!mockFileWatcher.updated);
+
+        engine.enableHotReload(&mockFileWatcher);
+        engine.update();
+
+        REQUIRE(mockFileWatcher.updated);
+    }
+
+    SECTION("Watched files notify of changes when hot reload is enabled") {
+        bool changed = false;
+        engine.enableHotReload(&mockFileWatcher);
+        engine.watchFile("map.json", [&] {
+            changed = true;
+        });
+
+        mockFileWatcher.simulateChange("map.json");
+
+        REQUIRE(changed);
+    }
+
+    SECTION("Tilemap reload only applies changed tiles") {
+        const std::string original =
+                R"({
+   "width":2,
+   "height":2,
+   "layers":[
+      {
+          "name":"Background",
+          "width":2,
+          "height":2,
+          "data":[
+              0, 1,
+              2, 3
+          ]
+      },
+      {
+          "type":"objectgroup",
+          "objects":[
+               {
+                   "type":"player_spawn",
+                   "x":1,
+                   "y":2
+               }
+           ]
+       }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+        const std::string updated =
+                R"({
+   "width":2,
+   "height":2,
+   "layers":[
+      {
+          "name":"Background",
+          "width":2,
+          "height":2,
+          "data":[
+              0, 1,
+              5, 3
+          ]
+      },
+      {
+          "type":"objectgroup",
+          "objects":[
+               {
+                   "type":"player_spawn",
+                   "x":10,
+                   "y":20
+               }
+           ]
+       }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(original, "tilemap.xyz");
+
+        REQUIRE(gameMap.reload(engine.createMap(updated, "tilemap.xyz")) == 1);
+        REQUIRE(gameMap.layer(0).tile(0, 1) == 5);
+        REQUIRE(gameMap.layer(0).tile(1, 1) == 3);
+        REQUIRE(gameMap.playerSpawnX() == 10);
+        REQUIRE(gameMap.playerSpawnY() == 20);
+
+        REQUIRE(gameMap.reload(engine.createMap(updated, "tilemap.xyz")) == 0);
+    }
+
+    SECTION("Sprite reload adopts a changed layout") {
+        SL::Sprite sprite = engine.createSprite("test.xyz", 32, 32);
+
+        REQUIRE(!sprite.reload(engine.createSprite("test.xyz", 32, 32)));
+        REQUIRE(sprite.reload(engine.createSprite("test.xyz", 64, 32)));
+        REQUIRE(sprite.frameCount() == 2);
+    }
+
+    SECTION("Playbacks sharing a clip survive it reloading with fewer frames") {
+        SL::Sprite sprite = engine.createSprite("test.xyz", 32, 32);
+        SL::AnimationPlayback other{sprite.clip().get(), 3, 10, false};
+
+        REQUIRE(sprite.reload(engine.createSprite("test.xyz", 64, 32)));
+        REQUIRE(sprite.frameCount() == 2);
+
+        other.advance(SL::AnimationClip::DefaultFrameDuration + 5);
+        REQUIRE(other.frame == 1);
+        REQUIRE(other.elapsed == 5);
+
+        other.draw(0, 0);
+        REQUIRE(mockGfx.drawnImage == "test.xyz,0,0,64,0,64,32,0");
+    }
+
+    SECTION("Infinite tilemaps are assembled from chunks") {
+        const std::string tilemap =
+                R"({
+   "width":2,
+   "height":2,
+   "infinite":true,
+   "tilewidth":16,
+   "tileheight":16,
+   "layers":[
+      {
+          "name":"Background",
+          "startx":-2,
+          "starty":0,
+          "width":4,
+          "height":2,
+          "chunks":[
+              {
+                  "x":-2,
+                  "y":0,
+                  "width":2,
+                  "height":2,
+                  "data":[1, 2,
+                          3, 4]
+              },
+              {
+                  "x":0,
+                  "y":0,
+                  "width":2,
+                  "height":2,
+                  "data":[5, 6,
+                          7, 8]
+              }
+          ]
+      },
+      {
+          "type":"objectgroup",
+          "objects":[
+               {
+                   "type":"player_spawn",
+                   "x":0,
+                   "y":0
+               }
+           ]
+       }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(gameMap.width() == 4);
+        REQUIRE(gameMap.height() == 2);
+        REQUIRE(gameMap.layer(0).tile(0, 0) == 1);
+        REQUIRE(gameMap.layer(0).tile(1, 1) == 4);
+        REQUIRE(gameMap.layer(0).tile(2, 0) == 5);
+        REQUIRE(gameMap.layer(0).tile(3, 1) == 8);
+        REQUIRE(gameMap.playerSpawnX() == 32);
+    }
+
+    SECTION("Chunk streamer keeps memory bounded across a large map") {
+        const uint32_t width = 10000;
+        const uint32_t height = 1000;
+        const uint32_t chunkSize = 16;
+
+        std::atomic<uint32_t> chunksLoaded{0};
+        SL::ChunkStreamer streamer{width, height, chunkSize, 2, [&](uint32_t chunkX, uint32_t chunkY) {
+            chunksLoaded++;
+            std::vector<uint32_t> tiles(chunkSize * chunkSize);
+            for (uint32_t i = 0; i < tiles.size(); i++) {
+                uint32_t x = chunkX * chunkSize + i % chunkSize;
+                uint32_t y = chunkY * chunkSize + i / chunkSize;
+                tiles[i] = y >= 500 ? 1 + (x + y) % 7 : 0;
+            }
+            return tiles;
+        }};
+
+        for (uint32_t x = 0; x < width; x += 40) {
+            uint32_t y = 480 + (x % 64);
+            streamer.focus(x, y);
+            streamer.wait();
+
+            REQUIRE(streamer.residentChunks() <= streamer.capacity());
+            REQUIRE(streamer.tile(x, y) == (y >= 500 ? 1 + (x + y) % 7 : 0));
+        }
+
+        REQUIRE(chunksLoaded > streamer.capacity() * 10);
+        REQUIRE(!streamer.resident(0, 0));
+
+        auto noTiles = [](uint32_t, uint32_t) { return std::vector<uint32_t>(); };
+        REQUIRE_THROWS_AS(SL::ChunkStreamer(0, height, chunkSize, 2, noTiles), const std::domain_error &);
+        REQUIRE_THROWS_AS(SL::ChunkStreamer(width, 0, chunkSize, 2, noTiles), const std::domain_error &);
+        REQUIRE_THROWS_AS(SL::ChunkStreamer(width, height, 0, 2, noTiles), const std::domain_error &);
+    }
+
+    SECTION("Infinite tilemap chunks must fit the map and their own size") {
+        const std::string outside =
+                R"({
+   "width":2,
+   "height":2,
+   "infinite":true,
+   "layers":[
+      {
+          "name":"Background",
+          "startx":0,
+          "starty":0,
+          "width":2,
+          "height":2,
+          "chunks":[
+              {
+                  "x":1,
+                  "y":0,
+                  "width":2,
+                  "height":2,
+                  "data":[1, 2, 3, 4]
+              }
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        const std::string truncated =
+                R"({
+   "width":2,
+   "height":2,
+   "infinite":true,
+   "layers":[
+      {
+          "name":"Background",
+          "startx":0,
+          "starty":0,
+          "width":2,
+          "height":2,
+          "chunks":[
+              {
+                  "x":0,
+                  "y":0,
+                  "width":2,
+                  "height":2,
+                  "data":[1, 2, 3]
+              }
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        REQUIRE_THROWS_AS(engine.createMap(outside, "tilemap.xyz"), const std::domain_error &);
+        REQUIRE_THROWS_AS(engine.createMap(truncated, "tilemap.xyz"), const std::domain_error &);
+    }
+
+    SECTION("Large infinite maps stream their chunks around the focus") {
+        // Generated by test/maps/generate_large_infinite.py, which describes the tiles checked here
+        std::ifstream file{SL_TEST_MAPS "large_infinite.json"};
+        std::stringstream mapData;
+        mapData << file.rdbuf();
+
+        REQUIRE(!mapData.str().empty());
+
+        auto gameMap = engine.createMap(mapData.str(), "tilemap.xyz");
+        SL::ChunkStreamer *streamer = gameMap.layer(0).streamer();
+
+        REQUIRE(gameMap.width() == 10000);
+        REQUIRE(gameMap.height() == 1000);
+        REQUIRE(gameMap.playerSpawnX() == 1600);
+        REQUIRE(gameMap.playerSpawnY() == 14400);
+        REQUIRE(streamer != nullptr);
+        REQUIRE(streamer->residentChunks() == 0);
+
+        gameMap.focus(10 * 16.0, 10 * 16.0);
+        gameMap.waitForChunks();
+
+        REQUIRE(gameMap.layer(0).tile(10, 10) == 9);
+        REQUIRE(gameMap.solid(10, 10));
+
+        for (uint32_t x = 0; x < 10000; x += 250) {
+            uint32_t y = 940 + x % 37;
+            gameMap.focus(x * 16.0, y * 16.0);
+            gameMap.waitForChunks();
+
+            REQUIRE(streamer->residentChunks() <= streamer->capacity());
+            REQUIRE(gameMap.layer(0).tile(x, y) == static_cast<int32_t>(1 + (x + y) % 7));
+            REQUIRE(gameMap.layer(0).tile(x, y - 1) == 0);
+            REQUIRE(gameMap.solid(x, y));
+            REQUIRE(!gameMap.solid(x, y - 1));
+        }
+
+        gameMap.focus(9990 * 16.0, 10 * 16.0);
+        gameMap.waitForChunks();
+
+        REQUIRE(gameMap.layer(0).tile(9990, 10) == 9);
+        REQUIRE(!streamer->resident(0, 0));
+        REQUIRE(!streamer->resident(0, 18));
+    }
+
+    SECTION("Base64 encoded tile layers can be parsed") {
+        const std::string tilemap =
+                R"({
+   "width":2,
+   "height":2,
+   "layers":[
+      {
+          "name":"Background",
+          "width":2,
+          "height":2,
+          "encoding":"base64",
+          "data":"AQAAAAIAAAADAAAABAAAAA=="
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(gameMap.layer(0).tile(0, 0) == 1);
+        REQUIRE(gameMap.layer(0).tile(1, 0) == 2);
+        REQUIRE(gameMap.layer(0).tile(0, 1) == 3);
+        REQUIRE(gameMap.layer(0).tile(1, 1) == 4);
+    }
+
+    SECTION("Zlib compressed tile layers can be parsed") {
+        const std::string tilemap =
+                R"({
+   "width":2,
+   "height":2,
+   "layers":[
+      {
+          "name":"Background",
+          "width":2,
+          "height":2,
+          "encoding":"base64",
+          "compression":"zlib",
+          "data":"eJxjZGBgYAJiZiBmAWIAAGAACw=="
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(gameMap.layer(0).tile(0, 0) == 1);
+        REQUIRE(gameMap.layer(0).tile(1, 0) == 2);
+        REQUIRE(gameMap.layer(0).tile(0, 1) == 3);
+        REQUIRE(gameMap.layer(0).tile(1, 1) == 4);
+    }
+
+    SECTION("Gzip compressed tile layers can be parsed") {
+        const std::string tilemap =
+                R"({
+   "width":2,
+   "height":2,
+   "layers":[
+      {
+          "name":"Background",
+          "width":2,
+          "height":2,
+          "encoding":"base64",
+          "compression":"gzip",
+          "data":"H4sIAAAAAAACA2NkYGBgAmJmIGYBYgDv1AWvEAAAAA=="
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(gameMap.layer(0).tile(0, 0) == 1);
+        REQUIRE(gameMap.layer(0).tile(1, 0) == 2);
+        REQUIRE(gameMap.layer(0).tile(0, 1) == 3);
+        REQUIRE(gameMap.layer(0).tile(1, 1) == 4);
+    }
+
+    SECTION("Truncated tile layer data is rejected") {
+        REQUIRE_THROWS_AS(SL::decodeTileData("AQAAAAIAAAADAAAA", "", 4), const std::domain_error &);
+        REQUIRE_THROWS_AS(SL::decodeTileData("AQAAAAIAAAADAAAABAAAAA==", "lzma", 4), const std::domain_error &);
+    }
+
+    SECTION("Startup profiler reports entries slowest first") {
+        SL::StartupProfiler profiler;
+        profiler.record("fast", 0, 10, 100);
+        profiler.record("slow", 10, 500, 200);
+        profiler.record("medium", 510, 50, 300);
+
+        auto entries = profiler.entries();
+
+        REQUIRE(entries.size() == 3);
+        REQUIRE(entries[0].label == "slow");
+        REQUIRE(entries[1].label == "medium");
+        REQUIRE(entries[2].label == "fast");
+
+        std::stringstream json;
+        profiler.reportJSON(json);
+        auto report = nlohmann::json::parse(json.str());
+
+        REQUIRE(report["entries"][0]["label"] == "slow");
+        REQUIRE(report["entries"][0]["bytes"] == 200);
+    }
+
+    SECTION("Engine records asset loads while profiling startup") {
+        SL::StartupProfiler profiler;
+        engine.profileStartup(&profiler);
+
+        engine.createSprite("test.xyz", 32, 32);
+
+        auto entries = profiler.entries();
+
+        REQUIRE(entries.size() == 1);
+        REQUIRE(entries[0].label == "loadImage test.xyz");
+        REQUIRE(entries[0].bytes == 128 * 32 * 4);
+
+        engine.profileStartup(nullptr);
+        engine.createSprite("test.xyz", 32, 32);
+
+        REQUIRE(profiler.entries().size() == 1);
+    }
+
+    SECTION("Engine records input with the frame it arrived on") {
+        SL::InputRecorder recorder;
+        engine.recordInput(&recorder);
+
+        mockTime.simulateTime(16L);
+        mockInput.simulateRightPress();
+        engine.update();
+        mockTime.simulateTime(33L);
+        engine.update();
+        mockTime.simulateTime(50L);
+        mockInput.simulateRightRelease();
+        mockInput.simulateJumpPress();
+        engine.update();
+
+        auto &recording = recorder.recording();
+
+        REQUIRE(recording.frameTimes.size() == 3);
+        REQUIRE(recording.frameTimes[1] == 17L);
+        REQUIRE(recording.keyEvents.size() == 3);
+        REQUIRE(recording.keyEvents[0].frame == 0);
+        REQUIRE(recording.keyEvents[1].frame == 2);
+        REQUIRE(recording.keyEvents[2].key == SL::KeyType::Jump);
+        REQUIRE(recording.keyEvents[2].action == SL::ActionType::Press);
+    }
+
+    SECTION("Replaying a recording reaches the same end state without waiting") {
+        SL::InputRecorder recorder;
+        engine.recordInput(&recorder);
+
+        long times[] = {16L, 33L, 50L, 66L, 83L};
+        for (long time : times) {
+            mockTime.simulateTime(time);
+            if (time == 33L) {
+                mockInput.simulateLeftPress();
+            } else if (time == 66L) {
+                mockInput.simulateLeftRelease();
+                mockInput.simulateDownPress();
+            }
+            engine.update();
+        }
+        mockInput.simulateQuit();
+        engine.update();
+
+        std::stringstream saved;
+        recorder.recording().write(saved);
+
+        SL::ReplayInput replay{SL::InputRecording::parse(saved.str())};
+        MockScene replayScene;
+        MockGfx replayGfx;
+        SL::Engine replayEngine{&replayGfx, &replay, &replay, &replay};
+        replayEngine.displayScene(&replayScene);
+
+        int32_t frames = 0;
+        while (replayEngine.update()) {
+            frames++;
+        }
+
+        REQUIRE(replay.finished());
+        REQUIRE(frames + 1 == mockScene.updates);
+        REQUIRE(replayScene.updates == mockScene.updates);
+        REQUIRE(replayScene.elapsedTime == mockScene.elapsedTime);
+        REQUIRE(replayScene.keyStream == mockScene.keyStream);
+        REQUIRE(replayScene.keyStream == "LdLuDd");
+    }
+
+    SECTION("Input queue lets every subscriber drain each tick once") {
+        SL::InputQueue queue{2};
+        SL::InputQueue::Cursor first{};
+        SL::InputQueue::Cursor second{};
+
+        REQUIRE(queue.push(SL::InputEvent{SL::KeyType::Left, SL::ActionType::Press, 100}));
+        REQUIRE(queue.push(SL::InputEvent{SL::KeyType::Jump, SL::ActionType::Press, 250}));
+        REQUIRE_FALSE(queue.push(SL::InputEvent{SL::KeyType::Jump, SL::ActionType::Release, 300}));
+
+        std::vector<uint64_t> firstSeen;
+        std::vector<uint64_t> secondSeen;
+        queue.drain(first, [&](const SL::InputEvent &event) { firstSeen.push_back(event.timestampMicros); });
+        queue.drain(first, [&](const SL::InputEvent &event) { firstSeen.push_back(event.timestampMicros); });
+        queue.drain(second, [&](const SL::InputEvent &event) { secondSeen.push_back(event.timestampMicros); });
+
+        REQUIRE(firstSeen.size() == 2);
+        REQUIRE(firstSeen[1] == 250);
+        REQUIRE(secondSeen == firstSeen);
+
+        queue.clear();
+        queue.push(SL::InputEvent{SL::KeyType::Left, SL::ActionType::Release, 400});
+        firstSeen.clear();
+        queue.drain(first, [&](const SL::InputEvent &event) { firstSeen.push_back(event.timestampMicros); });
+
+        REQUIRE(queue.size() == 1);
+        REQUIRE(queue.capacity() == 2);
+        REQUIRE(firstSeen.size() == 1);
+        REQUIRE(firstSeen[0] == 400);
+    }
+
+    SECTION("Input recordings with unknown keys are rejected") {
+        REQUIRE_THROWS_AS(SL::InputRecording::parse(R"({"frames":[16],"keys":[{"frame":0,"key":"fire","action":"press"}]})"), const std::domain_error &);
+    }
+
+    SECTION("Tile layers use the narrowest tile index the tileset allows") {
+        const std::string tilemap =
+                R"({
+   "width":2,
+   "height":1,
+   "layers":[
+      {
+          "name":"Background",
+          "width":2,
+          "height":1,
+          "data":[1, 100]
+      },
+      {
+          "name":"Middleground",
+          "width":2,
+          "height":1,
+          "data":[1, 70000]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+        mockGfx.simulateAvailableImage("large-tilemap.xyz", 2048, 2048);
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(gameMap.layer(0).bytesPerTile() == 1);
+        REQUIRE(gameMap.layer(0).tile(1, 0) == 100);
+        REQUIRE(gameMap.layer(1).bytesPerTile() == 4);
+        REQUIRE(gameMap.layer(1).tile(1, 0) == 70000);
+
+        auto largeTilesetMap = engine.createMap(tilemap, "large-tilemap.xyz");
+
+        REQUIRE(largeTilesetMap.layer(0).bytesPerTile() == 2);
+        REQUIRE(largeTilesetMap.layer(0).tile(1, 0) == 100);
+
+        largeTilesetMap.layer(0).draw(0, 0);
+
+        REQUIRE(mockGfx.drawnImage == "large-tilemap.xyz,16,0,1584,0,16,16,0");
+    }
+
+    SECTION("Blocked tile layout stores the same tiles as row major") {
+        SL::Image tileset{"tileset.xyz", 320, 192};
+        std::vector<uint32_t> tiles(21 * 13);
+        for (uint32_t i = 0; i < tiles.size(); i++) {
+            tiles[i] = (i * 7) % 240;
+        }
+
+        SL::Tilemap::Layer rowMajor{&mockGfx, tileset, 21, 13, tiles};
+        SL::Tilemap::Layer blocked{&mockGfx, tileset, 21, 13, tiles, SL::Tilemap::TileLayout::Blocked};
+
+        REQUIRE(rowMajor.layout() == SL::Tilemap::TileLayout::RowMajor);
+        REQUIRE(blocked.layout() == SL::Tilemap::TileLayout::Blocked);
+        for (uint32_t y = 0; y < 13; y++) {
+            for (uint32_t x = 0; x < 21; x++) {
+                REQUIRE(blocked.tile(x, y) == rowMajor.tile(x, y));
+            }
+        }
+
+        // Every tile is visited once, the first eight blocked visits stay within the first row of the first block
+        std::vector<uint32_t> visits(tiles.size());
+        std::vector<uint32_t> order;
+        blocked.visit([&](uint32_t x, uint32_t y, int32_t tile) {
+            visits[y * 21 + x]++;
+            order.push_back(y * 21 + x);
+            REQUIRE(tile == static_cast<int32_t>(tiles[y * 21 + x]));
+        });
+        REQUIRE(std::count(visits.begin(), visits.end(), 1) == 21 * 13);
+        for (uint32_t i = 0; i < 8; i++) {
+            REQUIRE(order[i] == i);
+        }
+        REQUIRE(order[8] == 21);
+
+        uint32_t regionTiles = 0;
+        blocked.visit(6, 5, 30, 9, [&](uint32_t x, uint32_t y, int32_t) {
+            REQUIRE(x >= 6);
+            REQUIRE(x <= 20);
+            REQUIRE(y >= 5);
+            REQUIRE(y <= 9);
+            regionTiles++;
+        });
+        REQUIRE(regionTiles == 15 * 5);
+    }
+
+    SECTION("Animated tiles follow their tileset clock") {
+        const std::string tilemap =
+                R"({
+   "width":2,
+   "height":1,
+   "layers":[
+      {
+          "name":"Background",
+          "width":2,
+          "height":1,
+          "data":[3, 0]
+      },
+      {
+          "name":"Middleground",
+          "width":2,
+          "height":1,
+          "data":[0, 3]
+      }
+   ],
+   "tilesets":[
+      {
+          "firstgid":1,
+          "tiles":[
+             {"id":2, "animation":[{"tileid":2, "duration":100}, {"tileid":4, "duration":50}, {"tileid":10, "duration":100}]}
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(&gameMap.layer(0).tileset() == &gameMap.layer(1).tileset());
+        REQUIRE(gameMap.layer(0).tileset().animationCount() == 1);
+        REQUIRE(gameMap.layer(0).tileset().frame(3) == 3);
+        REQUIRE(gameMap.layer(0).tileset().frame(2) == 2);
+        REQUIRE(gameMap.layer(0).tileset().frame(200) == 200);
+
+        gameMap.layer(0).draw(0, 0);
+        REQUIRE(mockGfx.drawnImage == "tilemap.xyz,0,0,32,0,16,16,0");
+
+        gameMap.update(99);
+        gameMap.layer(0).draw(0, 0);
+        REQUIRE(mockGfx.drawnImage == "tilemap.xyz,0,0,32,0,16,16,0");
+
+        // Both layers share the clock, which is only advanced once per map update
+        gameMap.update(1);
+        gameMap.layer(1).draw(0, 0);
+        REQUIRE(mockGfx.drawnImage == "tilemap.xyz,16,0,64,0,16,16,0");
+
+        gameMap.update(50);
+        gameMap.layer(0).draw(0, 0);
+        REQUIRE(mockGfx.drawnImage == "tilemap.xyz,0,0,0,16,16,16,0");
+
+        gameMap.update(100);
+        REQUIRE(gameMap.layer(1).tileset().frame(3) == 3);
+
+        // The tile's own gid is not the first frame, and frames need not be in order
+        SL::Tileset tileset{SL::Image{"tileset.xyz", 32, 32}};
+        tileset.addAnimation(1, {{4, 10}, {2, 10}});
+        REQUIRE(tileset.frame(1) == 4);
+        tileset.update(25);
+        REQUIRE(tileset.frame(1) == 4);
+        tileset.update(5);
+        REQUIRE(tileset.frame(1) == 2);
+    }
+
+    SECTION("Tileset precomputes source rects and flags per gid") {
+        const std::string tilemap =
+                R"({
+   "width":3,
+   "height":1,
+   "layers":[
+      {
+          "name":"Background",
+          "width":3,
+          "height":1,
+          "data":[12, 5, 7]
+      }
+   ],
+   "tilesets":[
+      {
+          "firstgid":1,
+          "tiles":[
+             {"id":4, "properties":[{"name":"flipped", "type":"bool", "value":true}]},
+             {"id":5, "properties":[{"name":"one_way", "type":"bool", "value":true}]},
+             {"id":6, "animation":[{"tileid":0, "duration":100}, {"tileid":1, "duration":100}]}
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+        SL::Tileset &tileset = gameMap.layer(0).tileset();
+
+        REQUIRE(tileset.tileCount() == 100);
+        REQUIRE(tileset.info(12).sourceX == 16);
+        REQUIRE(tileset.info(12).sourceY == 16);
+        REQUIRE(tileset.info(100).sourceX == 144);
+        REQUIRE(tileset.info(100).sourceY == 144);
+        REQUIRE(tileset.flags(12) == 0);
+        REQUIRE(tileset.flags(5) == SL::Tileset::TileFlipped);
+        REQUIRE(tileset.flags(6) == 0);
+        REQUIRE(tileset.flags(7) == SL::Tileset::TileAnimated);
+
+        gameMap.layer(0).draw(0, 0, 32, 16);
+        REQUIRE(mockGfx.drawnImage == "tilemap.xyz,16,0,64,0,16,16,1");
+
+        gameMap.layer(0).draw(0, 0);
+        REQUIRE(mockGfx.drawnImage == "tilemap.xyz,32,0,0,0,16,16,0");
+        REQUIRE(tileset.info(7).sourceX == 0);
+
+        gameMap.update(100);
+        REQUIRE(tileset.info(7).sourceX == 16);
+        REQUIRE(tileset.flags(7) == SL::Tileset::TileAnimated);
+    }
+
+    SECTION("Tile layout can be chosen with a map property") {
+        const std::string tilemap =
+                R"({
+   "width":10,
+   "height":2,
+   "layers":[
+      {
+          "name":"Background",
+          "width":10,
+          "height":2,
+          "data":[1, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3]
+      },
+      {
+          "name":"Middleground",
+          "width":10,
+          "height":2,
+          "data":[0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0],
+          "properties":[{"name":"tile_layout", "type":"string", "value":"row_major"}]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz",
+        "tile_layout": "blocked"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(gameMap.layer(0).layout() == SL::Tilemap::TileLayout::Blocked);
+        REQUIRE(gameMap.layer(1).layout() == SL::Tilemap::TileLayout::RowMajor);
+        REQUIRE(gameMap.layer(0).tile(0, 0) == 1);
+        REQUIRE(gameMap.layer(0).tile(9, 0) == 2);
+        REQUIRE(gameMap.layer(0).tile(9, 1) == 3);
+
+        // Tiles left of the view are culled, so the last tile drawn is the last visible one in memory order
+        gameMap.layer(0).draw(-144, 0, 32, 16);
+        REQUIRE(mockGfx.drawnImage == "tilemap.xyz,0,0,16,0,16,16,0");
+
+        mockGfx.drawnImage = "";
+        gameMap.layer(0).draw(0, 0, 16, 16);
+        REQUIRE(mockGfx.drawnImage == "tilemap.xyz,0,0,0,0,16,16,0");
+
+        mockGfx.drawnImage = "";
+        gameMap.layer(0).draw(-200, 0, 32, 32);
+        REQUIRE(mockGfx.drawnImage == "");
+
+        // A view partly off the left and top edges only draws the tiles it overlaps
+        gameMap.layer(0).draw(8, 8, 16, 16);
+        REQUIRE(mockGfx.drawnImage == "tilemap.xyz,8,8,0,0,16,16,0");
+
+        mockGfx.drawnImage = "";
+        gameMap.layer(0).draw(20, 0, 16, 16);
+        REQUIRE(mockGfx.drawnImage == "");
+
+        gameMap.layer(0).draw(0, 20, 16, 16);
+        REQUIRE(mockGfx.drawnImage == "");
+
+        REQUIRE_THROWS_AS(engine.createMap(R"({"width":1, "height":1, "layers":[], "properties":{"tile_layout":"spiral"}})", "tilemap.xyz"), const std::domain_error &);
+    }
+
+    SECTION("Collision layer can be declared with a layer property") {
+        const std::string tilemap =
+                R"({
+   "width":2,
+   "height":1,
+   "layers":[
+      {
+          "name":"Background",
+          "width":2,
+          "height":1,
+          "data":[1, 1]
+      },
+      {
+          "name":"Walls",
+          "width":2,
+          "height":1,
+          "data":[0, 3],
+          "properties":[
+              {
+                  "name":"collision",
+                  "type":"bool",
+                  "value":true
+              }
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(gameMap.collisionLayer() == 1);
+        REQUIRE(!gameMap.solid(0, 0));
+        REQUIRE(gameMap.solid(1, 0));
+        REQUIRE(!gameMap.solid(2, 0));
+        REQUIRE(!gameMap.solid(-1, 0));
+    }
+
+    SECTION("Collision spans can be queried across whole rows and columns") {
+        nlohmann::json tilemap = {
+                {"width",      130},
+                {"height",     3},
+                {"layers",     {{{"name", "Collision"}, {"width", 130}, {"height", 3}, {"data", std::vector<uint32_t>(390, 0)}}}},
+                {"properties", {{"background", "bg.xyz"}, {"middleground", "mg.xyz"}}}
+        };
+        tilemap["layers"][0]["data"][130 + 100] = 1;
+        tilemap["layers"][0]["data"][260 + 5] = 1;
+
+        auto gameMap = engine.createMap(tilemap.dump(), "tilemap.xyz");
+
+        REQUIRE(gameMap.solidRow(1, 0, 129));
+        REQUIRE(gameMap.solidRow(1, 60, 100));
+        REQUIRE(gameMap.solidRow(1, 100, 100));
+        REQUIRE(!gameMap.solidRow(1, 0, 99));
+        REQUIRE(!gameMap.solidRow(1, 101, 200));
+        REQUIRE(!gameMap.solidRow(0, 0, 129));
+        REQUIRE(gameMap.solidColumn(5, 0, 5));
+        REQUIRE(!gameMap.solidColumn(5, 0, 1));
+    }
+
+    SECTION("Sweeping a box resolves movement against every tile it passes") {
+        const std::string tilemap =
+                R"({
+   "width":4,
+   "height":8,
+   "layers":[
+      {
+          "name":"Collision",
+          "width":4,
+          "height":8,
+          "data":[
+              0, 0, 0, 0,
+              0, 0, 0, 0,
+              0, 0, 0, 0,
+              0, 0, 0, 1,
+              0, 0, 0, 0,
+              0, 0, 0, 0,
+              1, 1, 1, 1,
+              1, 1, 1, 1
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        SL::Tilemap::Sweep fall = gameMap.sweep(4, 0, 8, 8, 0, 100);
+
+        REQUIRE(fall.y == 88.0);
+        REQUIRE(fall.x == 4.0);
+        REQUIRE(fall.contacts == SL::Tilemap::ContactDown);
+
+        SL::Tilemap::Sweep standing = gameMap.sweep(4, 88, 8, 8, 0, 0.1);
+
+        REQUIRE(standing.y == 88.0);
+        REQUIRE(standing.contacts == SL::Tilemap::ContactDown);
+
+        SL::Tilemap::Sweep wall = gameMap.sweep(0, 50, 8, 8, 100, 0);
+
+        REQUIRE(wall.x == 40.0);
+        REQUIRE(wall.contacts == SL::Tilemap::ContactRight);
+
+        SL::Tilemap::Sweep clear = gameMap.sweep(0, 64, 8, 8, 100, 0);
+
+        REQUIRE(clear.x == 100.0);
+        REQUIRE(clear.contacts == 0);
+
+        SL::Tilemap::Sweep diagonal = gameMap.sweep(40, 80, 8, 8, -20, -40);
+
+        REQUIRE(diagonal.x == 20.0);
+        REQUIRE(diagonal.y == 40.0);
+        REQUIRE(diagonal.contacts == 0);
+
+        SL::Tilemap::Sweep ceiling = gameMap.sweep(50, 80, 8, 8, 0, -60);
+
+        REQUIRE(ceiling.y == 64.0);
+        REQUIRE(ceiling.contacts == SL::Tilemap::ContactUp);
+
+        SL::Tilemap::Sweep embedded = gameMap.sweep(4, 92, 8, 8, 0, 0.1);
+
+        REQUIRE(embedded.y == 88.0);
+        REQUIRE(embedded.contacts == SL::Tilemap::ContactDown);
+    }
+
+    SECTION("Walking off a ledge loses floor contact") {
+        const std::string tilemap =
+                R"({
+   "width":8,
+   "height":8,
+   "layers":[
+      {
+          "name":"Collision",
+          "width":8,
+          "height":8,
+          "data":[
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              1, 1, 1, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        // Walk right with gravity as the game does, remembering the last place the box stood
+        double x = 0.0;
+        double y = 56.0;
+        double ySpeed = 0.0;
+        double checkpointX = x;
+        bool onFloor = true;
+        for (int frame = 0; frame < 100 && y <= 128.0; frame++) {
+            ySpeed += 0.1;
+            SL::Tilemap::Sweep sweep = gameMap.sweep(x, y, 8, 8, 2.0, ySpeed);
+            x = sweep.x;
+            y = sweep.y;
+            onFloor = (sweep.contacts & SL::Tilemap::ContactDown) != 0;
+            if (onFloor) {
+                ySpeed = 0.0;
+                checkpointX = x;
+            }
+        }
+
+        REQUIRE(y > 128.0);
+        REQUIRE(!onFloor);
+        REQUIRE(checkpointX < 48.0);
+        REQUIRE(gameMap.sweep(checkpointX, 56, 8, 8, 0, 0.1).contacts == SL::Tilemap::ContactDown);
+    }
+
+    SECTION("Spatial grid finds overlapping entities") {
+        SL::SpatialGrid grid{4};
+
+        grid.insert(0, 10, 10, 16, 16);
+        grid.insert(1, 60, 10, 16, 16);
+        grid.insert(2, 500, 500, 16, 16);
+
+        std::vector<uint32_t> found;
+        grid.query(0, 0, 80, 32, found);
+        std::sort(found.begin(), found.end());
+
+        REQUIRE(grid.size() == 3);
+        REQUIRE(found.size() == 2);
+        REQUIRE(found[0] == 0);
+        REQUIRE(found[1] == 1);
+
+        grid.move(2, 20, 20, 16, 16);
+        found.clear();
+        grid.query(20, 20, 4, 4, found);
+        std::sort(found.begin(), found.end());
+
+        REQUIRE(found.size() == 2);
+        REQUIRE(found[0] == 0);
+        REQUIRE(found[1] == 2);
+
+        grid.remove(0);
+        found.clear();
+        grid.query(20, 20, 4, 4, found);
+
+        REQUIRE(grid.size() == 2);
+        REQUIRE(found.size() == 1);
+        REQUIRE(found[0] == 2);
+    }
+
+    SECTION("Spatial grid reports large entities once") {
+        SL::SpatialGrid grid{1};
+
+        grid.insert(7, -40, -40, 200, 200);
+
+        std::vector<uint32_t> found;
+        grid.query(-100, -100, 400, 400, found);
+
+        REQUIRE(found.size() == 1);
+        REQUIRE(found[0] == 7);
+    }
+
+    SECTION("Spatial grid ignores unknown ids and drops empty cells") {
+        SL::SpatialGrid grid{1};
+
+        grid.move(3, 0, 0, 8, 8);
+        grid.insert(0, 0, 0, 8, 8);
+        grid.move(5, 0, 0, 8, 8);
+
+        std::vector<uint32_t> found;
+        grid.query(0, 0, 8, 8, found);
+
+        REQUIRE(grid.size() == 1);
+        REQUIRE(found.size() == 1);
+        REQUIRE(found[0] == 0);
+        REQUIRE(grid.occupiedCells() == 1);
+
+        for (int32_t step = 1; step <= 100; step++) {
+            grid.move(0, step * 40.0, 0, 8, 8);
+        }
+
+        REQUIRE(grid.occupiedCells() == 1);
+
+        grid.remove(0);
+
+        REQUIRE(grid.occupiedCells() == 0);
+    }
+
+    SECTION("Activity scheduler ticks entities by distance from the view") {
+        SL::ActivityScheduler scheduler{4, 32, 128, 4};
+
+        scheduler.insert(0, 10, 10, 16, 16);
+        scheduler.insert(1, 180, 10, 16, 16);
+        scheduler.insert(2, 1000, 1000, 16, 16);
+
+        std::vector<SL::ActivityScheduler::Tick> ticks;
+        scheduler.update(1, 0, 0, 100, 100, ticks);
+
+        REQUIRE(ticks.size() == 2);
+        REQUIRE(ticks[0].id == 0);
+        REQUIRE(ticks[0].activity == SL::ActivityScheduler::Activity::Active);
+        REQUIRE(ticks[0].woke);
+        REQUIRE(ticks[0].elapsedFrames == 1);
+        REQUIRE(ticks[1].id == 1);
+        REQUIRE(ticks[1].activity == SL::ActivityScheduler::Activity::Reduced);
+        REQUIRE(scheduler.activity(2) == SL::ActivityScheduler::Activity::Asleep);
+
+        scheduler.update(2, 0, 0, 100, 100, ticks);
+
+        REQUIRE(ticks.size() == 1);
+        REQUIRE(ticks[0].id == 0);
+        REQUIRE_FALSE(ticks[0].woke);
+
+        scheduler.update(3, 0, 0, 100, 100, ticks);
+
+        REQUIRE(ticks.size() == 2);
+        REQUIRE(ticks[1].id == 1);
+        REQUIRE_FALSE(ticks[1].woke);
+        REQUIRE(ticks[1].elapsedFrames == 2);
+
+        scheduler.move(2, 50, 50, 16, 16);
+        scheduler.update(10, 0, 0, 100, 100, ticks);
+
+        REQUIRE(ticks.size() == 3);
+        REQUIRE(ticks[2].id == 2);
+        REQUIRE(ticks[2].woke);
+        REQUIRE(ticks[2].elapsedFrames == 10);
+
+        scheduler.remove(0);
+        scheduler.update(11, 0, 0, 100, 100, ticks);
+
+        REQUIRE(ticks.size() == 2);
+        REQUIRE(ticks[0].id == 1);
+        REQUIRE(ticks[1].id == 2);
+        REQUIRE(scheduler.activity(0) == SL::ActivityScheduler::Activity::Asleep);
+    }
+
+    SECTION("Tileset collision shapes give one way platforms and slopes") {
+        const std::string tilemap =
+                R"({
+   "width":4,
+   "height":4,
+   "layers":[
+      {
+          "name":"Collision",
+          "width":4,
+          "height":4,
+          "data":[
+              0, 0, 0, 0,
+              0, 0, 0, 0,
+              2, 0, 3, 0,
+              1, 1, 1, 1
+          ]
+      }
+   ],
+   "tilesets":[
+      {
+          "firstgid":1,
+          "tiles":[
+              {
+                  "id":1,
+                  "properties":[
+                      {
+                          "name":"one_way",
+                          "type":"bool",
+                          "value":true
+                      }
+                  ]
+              },
+              {
+                  "id":2,
+                  "objectgroup":{
+                      "objects":[
+                          {
+                              "x":0,
+                              "y":0,
+                              "polygon":[
+                                  {"x":0, "y":16},
+                                  {"x":16, "y":0},
+                                  {"x":16, "y":16}
+                              ]
+                          }
+                      ]
+                  }
+              }
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        REQUIRE(gameMap.shape(0, 2).type == SL::TileShape::OneWay);
+        REQUIRE(gameMap.shape(2, 2).type == SL::TileShape::Slope);
+        REQUIRE(gameMap.shape(2, 2).leftSurface == 16);
+        REQUIRE(gameMap.shape(2, 2).rightSurface == 0);
+        REQUIRE(gameMap.shape(0, 3).type == SL::TileShape::Solid);
+        REQUIRE(!gameMap.solid(0, 2));
+
+        SL::Tilemap::Sweep landOnPlatform = gameMap.sweep(4, 0, 8, 8, 0, 40);
+
+        REQUIRE(landOnPlatform.y == 24.0);
+        REQUIRE(landOnPlatform.contacts == SL::Tilemap::ContactDown);
+
+        SL::Tilemap::Sweep jumpThroughPlatform = gameMap.sweep(4, 40, 8, 8, 0, -20);
+
+        REQUIRE(jumpThroughPlatform.y == 20.0);
+        REQUIRE(jumpThroughPlatform.contacts == 0);
+
+        SL::Tilemap::Sweep walkThroughPlatform = gameMap.sweep(20, 34, 8, 8, -20, 0);
+
+        REQUIRE(walkThroughPlatform.x == 0.0);
+        REQUIRE(walkThroughPlatform.contacts == 0);
+
+        SL::Tilemap::Sweep landOnSlope = gameMap.sweep(32, 0, 8, 8, 0, 60);
+
+        REQUIRE(landOnSlope.y == 36.0);
+        REQUIRE(landOnSlope.contacts == SL::Tilemap::ContactDown);
+
+        SL::Tilemap::Sweep climbSlope = gameMap.sweep(32, 36, 8, 8, 4, 0.1);
+
+        REQUIRE(climbSlope.x == 36.0);
+        REQUIRE(climbSlope.y == 32.0);
+        REQUIRE(climbSlope.contacts == SL::Tilemap::ContactDown);
+    }
+
+    SECTION("Slopes lead onto solid ground level with their top") {
+        const std::string tilemap =
+                R"({
+   "width":8,
+   "height":6,
+   "layers":[
+      {
+          "name":"Collision",
+          "width":8,
+          "height":6,
+          "data":[
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 3, 1, 1, 1, 1,
+              1, 1, 1, 1, 1, 1, 1, 1
+          ]
+      }
+   ],
+   "tilesets":[
+      {
+          "firstgid":1,
+          "tiles":[
+              {
+                  "id":2,
+                  "objectgroup":{
+                      "objects":[
+                          {
+                              "x":0,
+                              "y":0,
+                              "polygon":[
+                                  {"x":0, "y":16},
+                                  {"x":16, "y":0},
+                                  {"x":16, "y":16}
+                              ]
+                          }
+                      ]
+                  }
+              }
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        // Stood halfway up the slope the box's right half is below the plateau's top, which used to stop it dead
+        SL::Tilemap::Sweep stepOntoPlateau = gameMap.sweep(56, 60, 8, 8, 2, 0.1);
+
+        REQUIRE(stepOntoPlateau.x == 58.0);
+        REQUIRE(stepOntoPlateau.y == 56.0);
+        REQUIRE(stepOntoPlateau.contacts == SL::Tilemap::ContactDown);
+
+        // Walk each way with gravity as the game does
+        double x = 16.0;
+        double y = 72.0;
+        double ySpeed = 0.0;
+        uint8_t contacts = 0;
+        for (int frame = 0; frame < 60 && x < 88.0; frame++) {
+            ySpeed += 0.1;
+            SL::Tilemap::Sweep sweep = gameMap.sweep(x, y, 8, 8, 2, ySpeed);
+            x = sweep.x;
+            y = sweep.y;
+            contacts = sweep.contacts;
+            if (contacts & SL::Tilemap::ContactDown) {
+                ySpeed = 0.0;
+            }
+        }
+
+        REQUIRE(x >= 88.0);
+        REQUIRE(y == 56.0);
+        REQUIRE(contacts == SL::Tilemap::ContactDown);
+
+        for (int frame = 0; frame < 60 && x > 16.0; frame++) {
+            ySpeed += 0.1;
+            SL::Tilemap::Sweep sweep = gameMap.sweep(x, y, 8, 8, -2, ySpeed);
+            x = sweep.x;
+            y = sweep.y;
+            contacts = sweep.contacts;
+            if (contacts & SL::Tilemap::ContactDown) {
+                ySpeed = 0.0;
+            }
+        }
+
+        REQUIRE(x <= 16.0);
+        REQUIRE(y == 72.0);
+        REQUIRE(contacts == SL::Tilemap::ContactDown);
+    }
+
+    SECTION("Tile shapes can come from an exported Tiled 1.0 tileset") {
+        const std::string tilemap =
+                R"({
+   "width":1,
+   "height":2,
+   "layers":[
+      {
+          "name":"Collision",
+          "width":1,
+          "height":2,
+          "data":[3, 2]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+        const std::string tileset =
+                R"({
+   "tileproperties":{
+      "1":{
+          "one_way":true
+      }
+   },
+   "tiles":{
+      "2":{
+          "objectgroup":{
+              "objects":[
+                  {
+                      "x":0,
+                      "y":8,
+                      "width":16,
+                      "height":8
+                  }
+              ]
+          }
+      }
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz", tileset);
+
+        REQUIRE(gameMap.shape(0, 1).type == SL::TileShape::OneWay);
+        REQUIRE(gameMap.shape(0, 0).type == SL::TileShape::Slope);
+        REQUIRE(gameMap.shape(0, 0).leftSurface == 8);
+        REQUIRE(gameMap.shape(0, 0).rightSurface == 8);
+    }
+
+    SECTION("Batches of bodies resolve the same as individual sweeps") {
+        nlohmann::json tilemap = {
+                {"width",      64},
+                {"height",     16},
+                {"layers",     {{{"name", "Collision"}, {"width", 64}, {"height", 16}, {"data", std::vector<uint32_t>(64 * 16, 0)}}}},
+                {"properties", {{"background", "bg.xyz"}, {"middleground", "mg.xyz"}}}
+        };
+        for (uint32_t x = 0; x < 64; x++) {
+            tilemap["layers"][0]["data"][15 * 64 + x] = 1;
+            tilemap["layers"][0]["data"][(x % 12) * 64 + x] = 1;
+        }
+
+        auto gameMap = engine.createMap(tilemap.dump(), "tilemap.xyz");
+
+        SL::BodyBatch bodies;
+        for (uint32_t i = 0; i < 2000; i++) {
+            bodies.add(i % 1000, (i * 7) % 200, 12, 12, (i % 9) - 4.0, (i % 13) - 3.0);
+        }
+
+        SL::BodyBatch serial = bodies;
+        SL::BodyBatch parallel = bodies;
+        gameMap.sweep(serial);
+        gameMap.sweep(parallel, 4);
+
+        for (uint32_t i = 0; i < bodies.size(); i++) {
+            SL::Tilemap::Sweep expected = gameMap.sweep(bodies.x[i], bodies.y[i], bodies.width[i], bodies.height[i], bodies.velocityX[i], bodies.velocityY[i]);
+
+            REQUIRE(serial.x[i] == expected.x);
+            REQUIRE(serial.y[i] == expected.y);
+            REQUIRE(serial.contacts[i] == expected.contacts);
+            REQUIRE(parallel.x[i] == expected.x);
+            REQUIRE(parallel.y[i] == expected.y);
+            REQUIRE(parallel.contacts[i] == expected.contacts);
+        }
+    }
+
+    SECTION("Rays report the first solid tile they reach") {
+        const std::string tilemap =
+                R"({
+   "width":8,
+   "height":8,
+   "layers":[
+      {
+          "name":"Collision",
+          "width":8,
+          "height":8,
+          "data":[
+              1, 1, 1, 1, 1, 1, 1, 1,
+              0, 0, 0, 0, 0, 1, 0, 0,
+              0, 0, 0, 0, 0, 1, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0,
+              0, 0, 0, 0, 0, 0, 0, 0
+          ]
+      }
+   ],
+   "properties": {
+        "background": "bg.xyz",
+        "middleground": "mg.xyz"
+   }
+})";
+
+        auto gameMap = engine.createMap(tilemap, "tilemap.xyz");
+
+        SL::Tilemap::RayHit wall = gameMap.raycast(8, 24, 1, 0, 1000);
+
+        REQUIRE(wall.hit);
+        REQUIRE(wall.tileX == 5);
+        REQUIRE(wall.tileY == 1);
+        REQUIRE(wall.x == 80.0);
+        REQUIRE(wall.y == 24.0);
+        REQUIRE(wall.normalX == -1);
+        REQUIRE(wall.normalY == 0);
+        REQUIRE(wall.distance == 72.0);
+
+        SL::Tilemap::RayHit ceiling = gameMap.raycast(24, 100, 0, -2, 1000);
+
+        REQUIRE(ceiling.hit);
+        REQUIRE(ceiling.tileY == 0);
+        REQUIRE(ceiling.y == 16.0);
+        REQUIRE(ceiling.normalY == 1);
+
+        SL::Tilemap::RayHit tooShort = gameMap.raycast(8, 24, 1, 0, 50);
+
+        REQUIRE(!tooShort.hit);
+        REQUIRE(tooShort.x == 58.0);
+
+        SL::Tilemap::RayHit offMap = gameMap.raycast(8, 100, 0, 1, 10000);
+
+        REQUIRE(!offMap.hit);
+
+        REQUIRE(gameMap.lineOfSight(8, 40, 120, 56));
+        REQUIRE(!gameMap.lineOfSight(8, 24, 120, 40));
+        REQUIRE(gameMap.intersectSegment(8, 24, 120, 40).tileX == 5);
+    }
+
+    SECTION("Registry hands out generation checked entity handles") {
+        SL::Registry registry;
+
+        SL::Entity first = registry.create();
+        SL::Entity second = registry.create();
+        REQUIRE(registry.size() == 2);
+        REQUIRE(registry.alive(first));
+
+        registry.destroy(first);
+        REQUIRE(!registry.alive(first));
+        REQUIRE(registry.alive(second));
+
+        SL::Entity reused = registry.create();
+        REQUIRE(reused.index == first.index);
+        REQUIRE(reused != first);
+        REQUIRE(!registry.alive(first));
+        REQUIRE(registry.size() == 2);
+
+        REQUIRE_THROWS_AS(registry.add<int>(first, 1), const std::domain_error &);
+    }
+
+    SECTION("Registry iterates entities with all requested components") {
+        struct Position {
+            double x;
+            double y;
+        };
+        struct Velocity {
+            double x;
+            double y;
+        };
+
+        SL::Registry registry;
+        std::vector<SL::Entity> entities;
+        for (uint32_t i = 0; i < 6; i++) {
+            entities.push_back(registry.create());
+            registry.add(entities[i], Position{static_cast<double>(i), 0.0});
+            if (i % 2 == 0) {
+                registry.add(entities[i], Velocity{1.0, 2.0});
+            }
+        }
+
+        REQUIRE(registry.pool<Position>().size() == 6);
+        REQUIRE(registry.pool<Velocity>().size() == 3);
+        REQUIRE(registry.has<Velocity>(entities[2]));
+        REQUIRE(!registry.has<Velocity>(entities[3]));
+
+        uint32_t moved = 0;
+        registry.each<Velocity, Position>([&](SL::Entity entity, Velocity &velocity, Position &position) {
+            REQUIRE(registry.alive(entity));
+            position.x += velocity.x;
+            position.y += velocity.y;
+            moved++;
+        });
+        REQUIRE(moved == 3);
+        REQUIRE(registry.get<Position>(entities[4]).x == 5.0);
+        REQUIRE(registry.get<Position>(entities[4]).y == 2.0);
+        REQUIRE(registry.get<Position>(entities[3]).y == 0.0);
+
+        // Removing from the middle keeps the remaining components packed and addressable
+        registry.destroy(entities[0]);
+        registry.remove<Velocity>(entities[2]);
+        REQUIRE(registry.pool<Position>().size() == 5);
+        REQUIRE(registry.pool<Velocity>().size() == 1);
+        REQUIRE(registry.get<Position>(entities[5]).x == 5.0);
+        REQUIRE(registry.get<Position>(entities[4]).x == 5.0);
+
+        uint32_t positions = 0;
+        registry.each<Position>([&](SL::Entity entity, Position &) {
+            REQUIRE(entity != entities[0]);
+            positions++;
+        });
+        REQUIRE(positions == 5);
+    }
+
+    SECTION("Object spawner creates entities for defined types with one reservation per pool") {
+        struct Position {
+            double x;
+            double y;
+        };
+        struct Patrol {
+            int32_t speed;
+        };
+
+        SL::Registry registry;
+        SL::ObjectSpawner spawner{registry};
+        spawner.define<Position, Patrol>("slug", [](SL::Registry &registry, SL::Entity entity, const SL::MapObject &object) {
+            registry.add(entity, Position{static_cast<double>(object.x), static_cast<double>(object.y)});
+            registry.add(entity, Patrol{object.properties["speed"].get<int32_t>()});
+        });
+        const Position *firstPosition = nullptr;
+        spawner.define<Position>("carrot", [&firstPosition](SL::Registry &registry, SL::Entity entity, const SL::MapObject &object) {
+            registry.add(entity, Position{static_cast<double>(object.x), static_cast<double>(object.y)});
+            if (firstPosition == nullptr) {
+                firstPosition = &registry.pool<Position>().at(0);
+            }
+        });
+
+        REQUIRE(spawner.defines("slug"));
+        REQUIRE(!spawner.defines("player_spawn"));
+
+        std::vector<SL::MapObject> objects;
+        objects.push_back(SL::MapObject{"player_spawn", "", 0, 0, 0, 0, nlohmann::json::object()});
+        for (int32_t i = 0; i < 300; i++) {
+            objects.push_back(SL::MapObject{i % 3 == 0 ? "slug" : "carrot", "", i, 2 * i, 16, 16, nlohmann::json{{"speed", i}}});
+        }
+
+        REQUIRE(spawner.spawn(objects) == 300);
+        REQUIRE(registry.size() == 300);
+        REQUIRE(registry.pool<Position>().size() == 300);
+        REQUIRE(registry.pool<Patrol>().size() == 100);
+
+        // Everything was reserved up front, so creating the objects never moved the dense arrays
+        REQUIRE(&registry.pool<Position>().at(0) == firstPosition);
+
+        uint32_t patrols = 0;
+        registry.each<Patrol, Position>([&](SL::Entity, Patrol &patrol, Position &position) {
+            REQUIRE(position.x == patrol.speed);
+            REQUIRE(position.y == 2 * patrol.speed);
+            patrols++;
+        });
+        REQUIRE(patrols == 100);
+    }
+
+    SECTION("Object pool reuses slots with generation checked handles") {
+        struct Effect {
+            int32_t x;
+            long age;
+        };
+
+        SL::ObjectPool<Effect> effects{3};
+        REQUIRE(effects.capacity() == 3);
+
+        SL::ObjectPool<Effect>::Handle first = effects.spawn(Effect{1, 0});
+        SL::ObjectPool<Effect>::Handle second = effects.spawn(Effect{2, 0});
+        SL::ObjectPool<Effect>::Handle third = effects.spawn(Effect{3, 0});
+        REQUIRE(effects.full());
+        REQUIRE(!effects.alive(effects.spawn(Effect{4, 0})));
+        REQUIRE(effects.get(second)->x == 2);
+
+        const Effect *storage = effects.get(first);
+        effects.despawn(second);
+        REQUIRE(!effects.alive(second));
+        REQUIRE(effects.get(second) == nullptr);
+        REQUIRE(effects.size() == 2);
+
+        // The freed slot is reused in place, the old handle stays stale
+        SL::ObjectPool<Effect>::Handle reused = effects.spawn(Effect{5, 0});
+        REQUIRE(reused.index == second.index);
+        REQUIRE(effects.get(second) == nullptr);
+        REQUIRE(effects.get(reused) == storage + 1);
+        REQUIRE(effects.get(reused)->x == 5);
+
+        effects.despawn(first);
+        effects.despawn(first);
+        REQUIRE(effects.size() == 2);
+
+        int32_t sum = 0;
+        effects.each([&](SL::ObjectPool<Effect>::Handle handle, Effect &effect) {
+            sum += effect.x;
+            effects.despawn(handle);
+        });
+        REQUIRE(sum == 8);
+        REQUIRE(effects.size() == 0);
+        REQUIRE(!effects.alive(third));
+    }
+
+    SECTION("Particles move, animate over their lifetime and are drawn in one batch") {
+        mockGfx.simulateAvailableImage("sparkle.xyz", 40, 10);
+        SL::ParticleSystem particles = engine.createParticles("sparkle.xyz", 10, 10, 3);
+        REQUIRE(particles.capacity() == 3);
+        particles.gravity(1000.0f);
+
+        REQUIRE(particles.emit(0.0f, 0.0f, 100.0f, 0.0f, 400.0f));
+        REQUIRE(particles.emit(50.0f, 50.0f, 0.0f, -100.0f, 100.0f));
+        REQUIRE(particles.emit(20.0f, 20.0f, 0.0f, 0.0f, 1000.0f));
+        REQUIRE(!particles.emit(0.0f, 0.0f, 0.0f, 0.0f, 100.0f));
+        REQUIRE(particles.size() == 3);
+
+        particles.update(50);
+        REQUIRE(particles.x(0) == Approx(5.0f));
+        REQUIRE(particles.y(0) == Approx(2.5f));
+        REQUIRE(particles.frame(0) == 0);
+        REQUIRE(particles.frame(1) == 2);
+
+        particles.draw(100, 200);
+        REQUIRE(mockGfx.quadBatches == 1);
+        REQUIRE(mockGfx.drawnQuadsImage == "sparkle.xyz");
+        REQUIRE(mockGfx.drawnQuads.size() == 3);
+        REQUIRE(mockGfx.drawnQuads[1].x == 150);
+        REQUIRE(mockGfx.drawnQuads[1].y == 200 + 47);
+        REQUIRE(mockGfx.drawnQuads[1].sourceX == 20);
+        REQUIRE(mockGfx.drawnQuads[1].width == 10);
+
+        // The expired second particle is replaced by the last one
+        particles.update(50);
+        REQUIRE(particles.size() == 2);
+        REQUIRE(particles.x(1) == 20.0f);
+        REQUIRE(particles.frame(0) == 1);
+
+        particles.update(1000);
+        REQUIRE(particles.size() == 0);
+
+        particles.draw(0, 0);
+        REQUIRE(mockGfx.quadBatches == 1);
+        REQUIRE(particles.emit(0.0f, 0.0f, 0.0f, 0.0f, 100.0f));
+    }
+
+    SECTION("Particles without a positive lifetime are not emitted") {
+        mockGfx.simulateAvailableImage("sparkle.xyz", 40, 10);
+        SL::ParticleSystem particles = engine.createParticles("sparkle.xyz", 10, 10, 3);
+
+        REQUIRE(!particles.emit(0.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+        REQUIRE(!particles.emit(0.0f, 0.0f, 0.0f, 0.0f, -100.0f));
+        REQUIRE(!particles.emit(0.0f, 0.0f, 0.0f, 0.0f, std::nanf("")));
+        REQUIRE(particles.size() == 0);
+
+        REQUIRE(particles.emit(0.0f, 0.0f, 0.0f, 0.0f, 0.5f));
+        particles.update(0);
+        REQUIRE(particles.frame(0) == 0);
+    }
 }
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Writes large_infinite.json, a 10,000x1,000 tile infinite Tiled map used to test chunk streaming.
+
+The ground is a band of rows along the bottom, with the surface at row 940 + x % 37, and each ground tile
+is gid 1 + (x + y) % 7. A gid 9 marker sits at tiles (10, 10) and (9990, 10) in the two top corner chunks,
+which are the only sky chunks saved, so the map's bounds are the full 10,000x1,000 tiles. Tiles are
+numbered from the top left of the map; in Tiled's own coordinates the map starts at (-5000, -500).
+"""
+
+import base64
+import json
+import os
+import struct
+import zlib
+
+WIDTH = 10000
+HEIGHT = 1000
+CHUNK = 50
+ORIGIN_X = -5000
+ORIGIN_Y = -500
+
+
+def tile(x, y):
+    if (x, y) in ((10, 10), (WIDTH - 10, 10)):
+        return 9
+    if y >= 940 + x % 37:
+        return 1 + (x + y) % 7
+    return 0
+
+
+def chunk(chunk_x, chunk_y):
+    tiles = [tile(chunk_x + i % CHUNK, chunk_y + i // CHUNK) for i in range(CHUNK * CHUNK)]
+    data = base64.b64encode(zlib.compress(struct.pack("<%dI" % len(tiles), *tiles), 9)).decode("ascii")
+    return {"x": chunk_x + ORIGIN_X, "y": chunk_y + ORIGIN_Y, "width": CHUNK, "height": CHUNK, "data": data}
+
+
+def main():
+    chunks = [chunk(0, 0)]
+    for chunk_y in range(900, HEIGHT, CHUNK):
+        for chunk_x in range(0, WIDTH, CHUNK):
+            chunks.append(chunk(chunk_x, chunk_y))
+    chunks.append(chunk(WIDTH - CHUNK, 0))
+
+    tilemap = {
+        "infinite": True,
+        "width": WIDTH,
+        "height": HEIGHT,
+        "tilewidth": 16,
+        "tileheight": 16,
+        "layers": [
+            {
+                "name": "Ground",
+                "startx": ORIGIN_X,
+                "starty": ORIGIN_Y,
+                "width": WIDTH,
+                "height": HEIGHT,
+                "encoding": "base64",
+                "compression": "zlib",
+                "properties": [{"name": "collision", "type": "bool", "value": True}],
+                "chunks": chunks,
+            },
+            {
+                "type": "objectgroup",
+                "objects": [{"type": "player_spawn", "x": 16 * (ORIGIN_X + 100), "y": 16 * (ORIGIN_Y + 900)}],
+            },
+        ],
+        "tilesets": [{"firstgid": 1, "source": "forest-tileset.json"}],
+        "properties": {"background": "bg.xyz", "middleground": "mg.xyz"},
+    }
+
+    with open(os.path.join(os.path.dirname(os.path.abspath(__file__)), "large_infinite.json"), "w") as out:
+        json.dump(tilemap, out, separators=(",", ":"))
+
+
+if __name__ == "__main__":
+    main()